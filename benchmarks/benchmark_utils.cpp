@@ -0,0 +1,48 @@
+#include "benchmark_utils.hpp"
+
+#include "libraries/pixel_buffer_pool/pixel_buffer_pool.hpp"
+
+#include <vector>
+
+namespace bnb::benchmarks
+{
+
+    /* add_resolutions */
+    void add_resolutions(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({"width", "height"});
+        benchmark->Args({1280, 720});
+        benchmark->Args({1920, 1080});
+        benchmark->Args({3840, 2160});
+    }
+
+    /* make_frame */
+    pixel_buffer_sptr make_frame(bnb::oep::interfaces::image_format format, int32_t width, int32_t height, int32_t row_padding)
+    {
+        std::vector<bnb::oep::interfaces::pixel_buffer::plane_data> planes;
+        for (int32_t plane = 0; plane < get_planes_count(format); ++plane) {
+            auto [row_size, rows] = get_plane_geometry(format, plane, width, height);
+            auto stride = row_size + row_padding;
+            auto size = static_cast<size_t>(stride) * rows;
+
+            std::shared_ptr<uint8_t> data(new uint8_t[size], std::default_delete<uint8_t[]>());
+            for (size_t i = 0; i < size; ++i) {
+                data.get()[i] = static_cast<uint8_t>((i * 7 + i / stride) & 0xff);
+            }
+            planes.push_back({data, size, stride});
+        }
+        return bnb::oep::interfaces::pixel_buffer::create(planes, format, width, height);
+    }
+
+    /* get_frame_size */
+    int64_t get_frame_size(bnb::oep::interfaces::image_format format, int32_t width, int32_t height)
+    {
+        int64_t size = 0;
+        for (int32_t plane = 0; plane < get_planes_count(format); ++plane) {
+            auto [row_size, rows] = get_plane_geometry(format, plane, width, height);
+            size += static_cast<int64_t>(row_size) * rows;
+        }
+        return size;
+    }
+
+} /* namespace bnb::benchmarks */
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <interfaces/pixel_buffer.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace bnb::benchmarks
+{
+
+    // Adds 720p, 1080p and 4K as {width, height} arguments
+    void add_resolutions(benchmark::internal::Benchmark* benchmark);
+
+    // A frame filled with a deterministic pattern. Every row of every plane is followed by
+    // row_padding unused bytes, as in frames of hardware decoders.
+    pixel_buffer_sptr make_frame(bnb::oep::interfaces::image_format format, int32_t width, int32_t height, int32_t row_padding = 0);
+
+    // Size of the visible pixels of the frame in bytes, without row padding
+    int64_t get_frame_size(bnb::oep::interfaces::image_format format, int32_t width, int32_t height);
+
+} /* namespace bnb::benchmarks */
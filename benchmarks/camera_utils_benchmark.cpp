@@ -0,0 +1,64 @@
+#include "benchmark_utils.hpp"
+
+#include "camera_utils.hpp"
+#include "effect_player.hpp"
+
+namespace
+{
+
+    using image_format = bnb::oep::interfaces::image_format;
+
+    bnb::full_image_t make_camera_image(const pixel_buffer_sptr& frame)
+    {
+        using ep = bnb::oep::effect_player;
+        auto format = ep::make_bnb_image_format(frame, bnb::oep::interfaces::rotation::deg0, false);
+        auto yuv_format = ep::make_bnb_yuv_format(frame);
+        if (frame->get_number_of_planes() == 2) {
+            return bnb::full_image_t(bnb::yuv_image_t(
+                bnb::color_plane(frame->get_base_sptr_of_plane(0)),
+                bnb::color_plane(frame->get_base_sptr_of_plane(1)),
+                format,
+                yuv_format));
+        }
+        return bnb::full_image_t(bnb::yuv_image_t(
+            bnb::color_plane(frame->get_base_sptr_of_plane(0)),
+            bnb::color_plane(frame->get_base_sptr_of_plane(1)),
+            bnb::color_plane(frame->get_base_sptr_of_plane(2)),
+            format,
+            yuv_format));
+    }
+
+    // Wrapping a camera image without copying
+    void full_image_to_pixel_buffer(benchmark::State& state, image_format format)
+    {
+        auto width = static_cast<int32_t>(state.range(0));
+        auto height = static_cast<int32_t>(state.range(1));
+        auto image = make_camera_image(bnb::benchmarks::make_frame(format, width, height));
+
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(bnb::camera_utils::full_image_to_pixel_buffer(image));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Copying a camera image into a pooled buffer
+    void full_image_to_pooled_pixel_buffer(benchmark::State& state, image_format format)
+    {
+        auto width = static_cast<int32_t>(state.range(0));
+        auto height = static_cast<int32_t>(state.range(1));
+        auto image = make_camera_image(bnb::benchmarks::make_frame(format, width, height));
+        auto pool = bnb::pixel_buffer_pool::create();
+
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(bnb::camera_utils::full_image_to_pixel_buffer(image, pool));
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * bnb::benchmarks::get_frame_size(format, width, height));
+    }
+
+} /* namespace */
+
+BENCHMARK_CAPTURE(full_image_to_pixel_buffer, nv12, image_format::nv12_bt601_full)->Apply(bnb::benchmarks::add_resolutions);
+BENCHMARK_CAPTURE(full_image_to_pixel_buffer, i420, image_format::i420_bt601_full)->Apply(bnb::benchmarks::add_resolutions);
+BENCHMARK_CAPTURE(full_image_to_pooled_pixel_buffer, nv12, image_format::nv12_bt601_full)->Apply(bnb::benchmarks::add_resolutions);
+BENCHMARK_CAPTURE(full_image_to_pooled_pixel_buffer, i420, image_format::i420_bt601_full)->Apply(bnb::benchmarks::add_resolutions);
@@ -0,0 +1,124 @@
+#include "benchmark_utils.hpp"
+
+#include "libraries/pixel_buffer_pool/pixel_buffer_pool.hpp"
+#include "libraries/pixel_conversion/pixel_conversion.hpp"
+
+#include <vector>
+
+namespace
+{
+
+    using namespace bnb::conversion;
+
+    // Returns nullptr and skips the benchmark if the CPU lacks the instruction set
+    const kernels* get_kernels_or_skip(benchmark::State& state, instruction_set isa)
+    {
+        if (static_cast<int>(isa) > static_cast<int>(get_supported_instruction_set())) {
+            state.SkipWithError("The instruction set is not supported by the CPU");
+            return nullptr;
+        }
+        return &get_kernels(isa);
+    }
+
+    void yuy2_to_nv12(benchmark::State& state, instruction_set isa)
+    {
+        auto kernels = get_kernels_or_skip(state, isa);
+        if (kernels == nullptr) {
+            return;
+        }
+        auto width = static_cast<int32_t>(state.range(0));
+        auto height = static_cast<int32_t>(state.range(1));
+        std::vector<uint8_t> src(static_cast<size_t>(width) * 2 * height, 0x80);
+        auto dst = bnb::benchmarks::make_frame(bnb::oep::interfaces::image_format::nv12_bt601_full, width, height);
+
+        for (auto _ : state) {
+            kernels->yuy2_to_nv12(
+                src.data(), width * 2,
+                dst->get_base_sptr_of_plane(0).get(), dst->get_bytes_per_row_of_plane(0),
+                dst->get_base_sptr_of_plane(1).get(), dst->get_bytes_per_row_of_plane(1),
+                width, height);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(src.size()));
+    }
+
+    void i420_to_nv12(benchmark::State& state, instruction_set isa)
+    {
+        auto kernels = get_kernels_or_skip(state, isa);
+        if (kernels == nullptr) {
+            return;
+        }
+        auto width = static_cast<int32_t>(state.range(0));
+        auto height = static_cast<int32_t>(state.range(1));
+        auto src = bnb::benchmarks::make_frame(bnb::oep::interfaces::image_format::i420_bt601_full, width, height);
+        auto dst = bnb::benchmarks::make_frame(bnb::oep::interfaces::image_format::nv12_bt601_full, width, height);
+
+        for (auto _ : state) {
+            kernels->i420_to_nv12(
+                src->get_base_sptr_of_plane(1).get(), src->get_bytes_per_row_of_plane(1),
+                src->get_base_sptr_of_plane(2).get(), src->get_bytes_per_row_of_plane(2),
+                dst->get_base_sptr_of_plane(1).get(), dst->get_bytes_per_row_of_plane(1),
+                width, height);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>((width + 1) / 2) * ((height + 1) / 2) * 2);
+    }
+
+    void nv12_to_i420(benchmark::State& state, instruction_set isa)
+    {
+        auto kernels = get_kernels_or_skip(state, isa);
+        if (kernels == nullptr) {
+            return;
+        }
+        auto width = static_cast<int32_t>(state.range(0));
+        auto height = static_cast<int32_t>(state.range(1));
+        auto src = bnb::benchmarks::make_frame(bnb::oep::interfaces::image_format::nv12_bt601_full, width, height);
+        auto dst = bnb::benchmarks::make_frame(bnb::oep::interfaces::image_format::i420_bt601_full, width, height);
+
+        for (auto _ : state) {
+            kernels->nv12_to_i420(
+                src->get_base_sptr_of_plane(1).get(), src->get_bytes_per_row_of_plane(1),
+                dst->get_base_sptr_of_plane(1).get(), dst->get_bytes_per_row_of_plane(1),
+                dst->get_base_sptr_of_plane(2).get(), dst->get_bytes_per_row_of_plane(2),
+                width, height);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>((width + 1) / 2) * ((height + 1) / 2) * 2);
+    }
+
+    template<swizzle_fn kernels::*kernel, int32_t src_bpp, int32_t dst_bpp>
+    void swizzle(benchmark::State& state, instruction_set isa)
+    {
+        auto kernels = get_kernels_or_skip(state, isa);
+        if (kernels == nullptr) {
+            return;
+        }
+        auto width = static_cast<int32_t>(state.range(0));
+        auto height = static_cast<int32_t>(state.range(1));
+        std::vector<uint8_t> src(static_cast<size_t>(width) * src_bpp * height, 0x40);
+        std::vector<uint8_t> dst(static_cast<size_t>(width) * dst_bpp * height);
+
+        for (auto _ : state) {
+            (kernels->*kernel)(src.data(), width * src_bpp, dst.data(), width * dst_bpp, width, height);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(src.size()));
+    }
+
+    auto rgba_to_bgra = swizzle<&kernels::rgba_to_bgra, 4, 4>;
+    auto rgb_to_bgra = swizzle<&kernels::rgb_to_bgra, 3, 4>;
+    auto bgra_to_rgb = swizzle<&kernels::bgra_to_rgb, 4, 3>;
+
+} /* namespace */
+
+#define BNB_CONVERSION_BENCHMARK(kernel)                                                \
+    BENCHMARK_CAPTURE(kernel, scalar, instruction_set::scalar)->Apply(bnb::benchmarks::add_resolutions); \
+    BENCHMARK_CAPTURE(kernel, sse41, instruction_set::sse41)->Apply(bnb::benchmarks::add_resolutions);   \
+    BENCHMARK_CAPTURE(kernel, avx2, instruction_set::avx2)->Apply(bnb::benchmarks::add_resolutions)
+
+BNB_CONVERSION_BENCHMARK(yuy2_to_nv12);
+BNB_CONVERSION_BENCHMARK(i420_to_nv12);
+BNB_CONVERSION_BENCHMARK(nv12_to_i420);
+BNB_CONVERSION_BENCHMARK(rgba_to_bgra);
+BNB_CONVERSION_BENCHMARK(rgb_to_bgra);
+BNB_CONVERSION_BENCHMARK(bgra_to_rgb);
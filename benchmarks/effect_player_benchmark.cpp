@@ -0,0 +1,55 @@
+#include "benchmark_utils.hpp"
+
+#include <interfaces/effect_player.hpp>
+
+#if !BNB_STUB_EFFECT_PLAYER
+    #include "effect_player.hpp"
+#endif
+
+namespace
+{
+
+    using image_format = bnb::oep::interfaces::image_format;
+
+#if !BNB_STUB_EFFECT_PLAYER
+    // Translation of OEP frame descriptions into the SDK ones, done for every pushed frame
+    void make_bnb_formats(benchmark::State& state, image_format format)
+    {
+        using ep = bnb::oep::effect_player;
+        auto frame = bnb::benchmarks::make_frame(format, 1280, 720);
+
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(ep::make_bnb_image_format(frame, bnb::oep::interfaces::rotation::deg90, true));
+            benchmark::DoNotOptimize(&ep::get_frame_descriptor(frame->get_image_format()));
+        }
+    }
+#endif
+
+    // effect_player::push_frame without draw(): format dispatch, packing of padded rows
+    // and the handoff to the SDK (or the stub)
+    void push_frame(benchmark::State& state, image_format format, int32_t row_padding)
+    {
+        auto width = static_cast<int32_t>(state.range(0));
+        auto height = static_cast<int32_t>(state.range(1));
+        auto effect_player = bnb::oep::interfaces::effect_player::create(width, height);
+        auto frame = bnb::benchmarks::make_frame(format, width, height, row_padding);
+
+        for (auto _ : state) {
+            effect_player->push_frame(frame, bnb::oep::interfaces::rotation::deg0, false);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+} /* namespace */
+
+#if !BNB_STUB_EFFECT_PLAYER
+BENCHMARK_CAPTURE(make_bnb_formats, nv12_bt709_video, image_format::nv12_bt709_video);
+BENCHMARK_CAPTURE(make_bnb_formats, i420_bt601_full, image_format::i420_bt601_full);
+BENCHMARK_CAPTURE(make_bnb_formats, bgra, image_format::bpc8_bgra);
+#endif
+
+BENCHMARK_CAPTURE(push_frame, nv12, image_format::nv12_bt601_full, 0)->Apply(bnb::benchmarks::add_resolutions);
+BENCHMARK_CAPTURE(push_frame, nv12_padded, image_format::nv12_bt601_full, 64)->Apply(bnb::benchmarks::add_resolutions);
+BENCHMARK_CAPTURE(push_frame, i420, image_format::i420_bt601_full, 0)->Apply(bnb::benchmarks::add_resolutions);
+BENCHMARK_CAPTURE(push_frame, rgba, image_format::bpc8_rgba, 0)->Apply(bnb::benchmarks::add_resolutions);
+BENCHMARK_CAPTURE(push_frame, bgra, image_format::bpc8_bgra, 0)->Apply(bnb::benchmarks::add_resolutions);
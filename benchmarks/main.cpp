@@ -0,0 +1,31 @@
+#include <benchmark/benchmark.h>
+
+#if !BNB_STUB_EFFECT_PLAYER
+    #include <bnb/effect_player/utility.hpp>
+#endif
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+#if !BNB_STUB_EFFECT_PLAYER
+    // The SDK is initialized once for all benchmarks, the client token is taken from the environment
+    auto client_token = std::getenv("BNB_CLIENT_TOKEN");
+    if (client_token == nullptr) {
+        std::cout << "[ERROR] Set the BNB_CLIENT_TOKEN environment variable to the client token" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> dirs {BNB_RESOURCES_FOLDER};
+    bnb::utility utility(dirs, client_token);
+#endif
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
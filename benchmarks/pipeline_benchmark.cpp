@@ -0,0 +1,117 @@
+#include "benchmark_utils.hpp"
+
+#include <interfaces/offscreen_effect_player.hpp>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+
+namespace
+{
+
+    using image_format = bnb::oep::interfaces::image_format;
+
+    // Frames submitted before waiting for the oldest result, as in the example
+    constexpr int32_t max_frames_in_flight = 2;
+    // Frames processed before timing starts, they include shader compilation and effect loading
+    constexpr int32_t warm_up_frames = 10;
+    // If the OEP does not return a frame in this time it is considered lost
+    constexpr std::chrono::seconds result_timeout {10};
+
+    struct processing_state
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        int32_t frames_in_flight {0};
+    };
+
+    offscreen_effect_player_sptr create_oep(int32_t width, int32_t height)
+    {
+        auto rc = bnb::oep::interfaces::render_context::create();
+        auto ort = bnb::oep::interfaces::offscreen_render_target::create(rc);
+        auto ep = bnb::oep::interfaces::effect_player::create(width, height);
+        auto oep = bnb::oep::interfaces::offscreen_effect_player::create(ep, ort, width, height);
+        // Without an effect the SDK only renders the camera frame
+        if (auto effect = std::getenv("BNB_BENCHMARK_EFFECT")) {
+            oep->load_effect(effect);
+        }
+        return oep;
+    }
+
+    // Waits for a free slot and submits the frame, returns false if the OEP stopped returning frames
+    bool submit_frame(const offscreen_effect_player_sptr& oep, const std::shared_ptr<processing_state>& state, const pixel_buffer_sptr& frame)
+    {
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if (!state->cv.wait_for(lock, result_timeout, [&state]() { return state->frames_in_flight < max_frames_in_flight; })) {
+                return false;
+            }
+            ++state->frames_in_flight;
+        }
+
+        // The callback may outlive the benchmark if the OEP loses a frame, so the state is shared
+        oep->process_image_async(frame, bnb::oep::interfaces::rotation::deg0, false, [state](image_processing_result_sptr result) {
+            if (result != nullptr) {
+                result->get_texture([](std::optional<rendered_texture_t>) {});
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                --state->frames_in_flight;
+            }
+            state->cv.notify_all();
+        }, bnb::oep::interfaces::rotation::deg0);
+        return true;
+    }
+
+    bool wait_all_frames(const std::shared_ptr<processing_state>& state)
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        return state->cv.wait_for(lock, result_timeout, [&state]() { return state->frames_in_flight == 0; });
+    }
+
+    // Frames per second through process_image_async with max_frames_in_flight frames in flight.
+    // The last frames in flight are not timed, which is negligible against the iteration count.
+    void end_to_end(benchmark::State& state, image_format format)
+    {
+        auto width = static_cast<int32_t>(state.range(0));
+        auto height = static_cast<int32_t>(state.range(1));
+        auto oep = create_oep(width, height);
+        auto processing = std::make_shared<processing_state>();
+
+        // Several frames in rotation, so the same buffer is not pushed while the OEP still reads it
+        std::array<pixel_buffer_sptr, max_frames_in_flight + 2> frames;
+        for (auto& frame : frames) {
+            frame = bnb::benchmarks::make_frame(format, width, height);
+        }
+
+        size_t next_frame = 0;
+        for (int32_t i = 0; i < warm_up_frames; ++i) {
+            submit_frame(oep, processing, frames[next_frame++ % frames.size()]);
+        }
+        if (!wait_all_frames(processing)) {
+            state.SkipWithError("The OEP stopped returning frames");
+            return;
+        }
+
+        for (auto _ : state) {
+            if (!submit_frame(oep, processing, frames[next_frame++ % frames.size()])) {
+                state.SkipWithError("The OEP stopped returning frames");
+                break;
+            }
+        }
+        if (!wait_all_frames(processing)) {
+            state.SkipWithError("The OEP stopped returning frames");
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    }
+
+} /* namespace */
+
+BENCHMARK_CAPTURE(end_to_end, nv12, image_format::nv12_bt601_full)->Apply(bnb::benchmarks::add_resolutions)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(end_to_end, i420, image_format::i420_bt601_full)->Apply(bnb::benchmarks::add_resolutions)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(end_to_end, rgba, image_format::bpc8_rgba)->Apply(bnb::benchmarks::add_resolutions)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(end_to_end, bgra, image_format::bpc8_bgra)->Apply(bnb::benchmarks::add_resolutions)->UseRealTime()->Unit(benchmark::kMillisecond);
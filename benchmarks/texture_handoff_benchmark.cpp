@@ -0,0 +1,54 @@
+#include "benchmark_utils.hpp"
+
+#include "libraries/renderer/texture_triple_buffer.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+
+    // Publish and consume on one thread, the cost of the handoff itself
+    void texture_handoff(benchmark::State& state)
+    {
+        bnb::render::texture_triple_buffer frames;
+        uint64_t sequence = 0;
+        bool is_new_frame = false;
+
+        for (auto _ : state) {
+            frames.publish({1, ++sequence, nullptr});
+            benchmark::DoNotOptimize(frames.consume(is_new_frame));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // The render thread consumes while a producer thread publishes as fast as it can,
+    // as when the OEP returns frames faster than the display refresh rate
+    void texture_handoff_contended(benchmark::State& state)
+    {
+        bnb::render::texture_triple_buffer frames;
+        std::atomic_bool is_running {true};
+        std::thread producer([&frames, &is_running]() {
+            uint64_t sequence = 0;
+            while (is_running.load(std::memory_order_relaxed)) {
+                frames.publish({1, ++sequence, nullptr});
+            }
+        });
+
+        int64_t new_frames = 0;
+        bool is_new_frame = false;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(frames.consume(is_new_frame));
+            new_frames += is_new_frame ? 1 : 0;
+        }
+
+        is_running = false;
+        producer.join();
+        state.SetItemsProcessed(state.iterations());
+        state.counters["new_frames"] = benchmark::Counter(static_cast<double>(new_frames) / static_cast<double>(state.iterations()));
+    }
+
+} /* namespace */
+
+BENCHMARK(texture_handoff);
+BENCHMARK(texture_handoff_contended)->UseRealTime();
@@ -2,77 +2,89 @@
 
 #include <interfaces/image_format.hpp>
 
+#include <cstring>
 #include <iostream>
+#include <optional>
+
+namespace
+{
+
+    std::optional<bnb::oep::interfaces::image_format> yuv_image_to_image_format(const bnb::yuv_image_t& yuv_image)
+    {
+        auto yuv_format = yuv_image.get_yuv_format();
+
+        /* This is a little hack that makes code more linear.
+        * But it only works if there are exactly two parameters each enum. If new ones are added, the code needs to be rewritten.
+        * used bitmasks:
+        * 0b00000100 (0x04) - if the bit is set, then used yuv_format::yuv_nv12   otherwise yuv_format::yuv_i420
+        * 0b00000010 (0x02) - if the bit is set, then used color_std::bt601       otherwise color_std::bt709
+        * 0b00000001 (0x01) - if the bit is set, then used color_range::full      otherwise color_range::video
+        */
+        uint8_t tocase =
+            (static_cast<uint8_t>(yuv_format.format == bnb::yuv_format::yuv_nv12) << 2) |
+            (static_cast<uint8_t>(yuv_format.standard == bnb::color_std::bt601) << 1) |
+            (static_cast<uint8_t>(yuv_format.range == bnb::color_range::full) << 0);
+        /* 'switch' below handles all existing bitmask variations */
+        switch (tocase) {
+            case 0b000:
+                return bnb::oep::interfaces::image_format::i420_bt709_video;
+            case 0b001:
+                return bnb::oep::interfaces::image_format::i420_bt709_full;
+            case 0b010:
+                return bnb::oep::interfaces::image_format::i420_bt601_video;
+            case 0b011:
+                return bnb::oep::interfaces::image_format::i420_bt601_full;
+            case 0b100:
+                return bnb::oep::interfaces::image_format::nv12_bt709_video;
+            case 0b101:
+                return bnb::oep::interfaces::image_format::nv12_bt709_full;
+            case 0b110:
+                return bnb::oep::interfaces::image_format::nv12_bt601_video;
+            case 0b111:
+                return bnb::oep::interfaces::image_format::nv12_bt601_full;
+            default:
+                return std::nullopt;
+        }
+    }
+
+} /* namespace */
 
 namespace bnb
 {
 
-    pixel_buffer_sptr camera_utils::full_image_to_pixel_buffer(bnb::full_image_t &image)
+    pixel_buffer_sptr camera_utils::full_image_to_pixel_buffer(bnb::full_image_t &image, const plane_strides& strides)
     {
         int32_t width = image.get_format().width;
         int32_t height = image.get_format().height;
-        int32_t stride = image.get_format().width;
 
         if (image.has_data<bnb::yuv_image_t>()) {
             auto yuv_image = image.get_data<bnb::yuv_image_t>();
-            auto yuv_format = yuv_image.get_yuv_format();
-
-            bnb::oep::interfaces::image_format outfmt;
-            /* This is a little hack that makes code more linear.
-            * But it only works if there are exactly two parameters each enum. If new ones are added, the code needs to be rewritten.
-            * used bitmasks:
-            * 0b00000100 (0x04) - if the bit is set, then used yuv_format::yuv_nv12   otherwise yuv_format::yuv_i420
-            * 0b00000010 (0x02) - if the bit is set, then used color_std::bt601       otherwise color_std::bt709
-            * 0b00000001 (0x01) - if the bit is set, then used color_range::full      otherwise color_range::video
-            */
-            uint8_t tocase =
-                (static_cast<uint8_t>(yuv_format.format == bnb::yuv_format::yuv_nv12) << 2) |
-                (static_cast<uint8_t>(yuv_format.standard == bnb::color_std::bt601) << 1) |
-                (static_cast<uint8_t>(yuv_format.range == bnb::color_range::full) << 0);
-            /* 'switch' below handles all existing bitmask variations */
-            switch (tocase) {
-                case 0b000:
-                    outfmt = bnb::oep::interfaces::image_format::i420_bt709_video;
-                    break;
-                case 0b001:
-                    outfmt = bnb::oep::interfaces::image_format::i420_bt709_full;
-                    break;
-                case 0b010:
-                    outfmt = bnb::oep::interfaces::image_format::i420_bt601_video;
-                    break;
-                case 0b011:
-                    outfmt = bnb::oep::interfaces::image_format::i420_bt601_full;
-                    break;
-                case 0b100:
-                    outfmt = bnb::oep::interfaces::image_format::nv12_bt709_video;
-                    break;
-                case 0b101:
-                    outfmt = bnb::oep::interfaces::image_format::nv12_bt709_full;
-                    break;
-                case 0b110:
-                    outfmt = bnb::oep::interfaces::image_format::nv12_bt601_video;
-                    break;
-                case 0b111:
-                    outfmt = bnb::oep::interfaces::image_format::nv12_bt601_full;
-                    break;
-                default:
-                    std::cout << "[ERROR] Unknown yuv image format" << std::endl;
-                    return nullptr;
+            auto outfmt = yuv_image_to_image_format(yuv_image);
+            if (!outfmt.has_value()) {
+                std::cout << "[ERROR] Unknown yuv image format" << std::endl;
+                return nullptr;
             }
 
-            if (tocase & 0b100) { /* nv12 2 planes */
+            /* chroma planes are half width and half height, NV12 chroma rows hold interleaved U and V */
+            auto make_plane = [&](bnb::color_plane data, int32_t plane) -> bnb::oep::interfaces::pixel_buffer::plane_data {
+                auto geometry = get_plane_geometry(*outfmt, plane, width, height);
+                int32_t stride = strides[plane] > 0 ? strides[plane] : geometry.row_size;
+                return {std::move(data), static_cast<size_t>(stride) * geometry.rows, stride};
+            };
+
+            if (yuv_image.get_yuv_format().format == bnb::yuv_format::yuv_nv12) { /* nv12 2 planes */
                 std::vector<bnb::oep::interfaces::pixel_buffer::plane_data> planes {
-                    {yuv_image.get_plane<0>(), 0, stride},
-                    {yuv_image.get_plane<1>(), 0, stride}
+                    make_plane(yuv_image.get_plane<0>(), 0),
+                    make_plane(yuv_image.get_plane<1>(), 1)
                 };
-                return bnb::oep::interfaces::pixel_buffer::create(planes, outfmt, width, height);
+                return bnb::oep::interfaces::pixel_buffer::create(planes, *outfmt, width, height);
             } else { /* i420 - 3 planes */
                 std::vector<bnb::oep::interfaces::pixel_buffer::plane_data> planes {
-                    {yuv_image.get_plane<0>(), 0, stride},
-                    {yuv_image.get_plane<1>(), 0, stride},
-                    {yuv_image.get_plane<2>(), 0, stride}
+                    make_plane(yuv_image.get_plane<0>(), 0),
+                    make_plane(yuv_image.get_plane<1>(), 1),
+                    make_plane(yuv_image.get_plane<2>(), 2)
                 };
-                return bnb::oep::interfaces::pixel_buffer::create(planes, outfmt, width, height);
+                return bnb::oep::interfaces::pixel_buffer::create(planes, *outfmt, width, height);
             }
             return nullptr;
         }
@@ -81,4 +93,46 @@ namespace bnb
         return nullptr;
     }
 
+    pixel_buffer_sptr camera_utils::full_image_to_pixel_buffer(bnb::full_image_t &image, const pixel_buffer_pool_sptr& pool, const plane_strides& strides)
+    {
+        int32_t width = image.get_format().width;
+        int32_t height = image.get_format().height;
+
+        if (!image.has_data<bnb::yuv_image_t>()) {
+            std::cout << "[ERROR] not yuv image" << std::endl;
+            return nullptr;
+        }
+
+        auto yuv_image = image.get_data<bnb::yuv_image_t>();
+        auto outfmt = yuv_image_to_image_format(yuv_image);
+        if (!outfmt.has_value()) {
+            std::cout << "[ERROR] Unknown yuv image format" << std::endl;
+            return nullptr;
+        }
+
+        auto pb = pool->acquire(*outfmt, width, height);
+        if (pb == nullptr) {
+            return nullptr;
+        }
+
+        bool is_nv12 = yuv_image.get_yuv_format().format == bnb::yuv_format::yuv_nv12;
+        const uint8_t* src_planes[] = {
+            yuv_image.get_plane<0>().get(),
+            yuv_image.get_plane<1>().get(),
+            is_nv12 ? nullptr : yuv_image.get_plane<2>().get()
+        };
+
+        for (int32_t plane = 0; plane < pb->get_number_of_planes(); ++plane) {
+            auto geometry = get_plane_geometry(*outfmt, plane, width, height);
+            int32_t src_stride = strides[plane] > 0 ? strides[plane] : geometry.row_size;
+            int32_t dst_stride = pb->get_bytes_per_row_of_plane(plane);
+            auto dst = pb->get_base_sptr_of_plane(plane).get();
+            auto src = src_planes[plane];
+            for (int32_t row = 0; row < geometry.rows; ++row) {
+                std::memcpy(dst + static_cast<size_t>(row) * dst_stride, src + static_cast<size_t>(row) * src_stride, geometry.row_size);
+            }
+        }
+        return pb;
+    }
+
 } /* namespace bnb */
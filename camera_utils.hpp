@@ -3,14 +3,27 @@
 #include <interfaces/pixel_buffer.hpp>
 #include <bnb/spal/camera/base.hpp>
 
+#include "libraries/pixel_buffer_pool/pixel_buffer_pool.hpp"
+
+#include <array>
+
 namespace bnb
 {
 
     class camera_utils {
     public:
+        // Row pitch in bytes of each plane of the source image, e.g. 64 or 128 byte aligned rows
+        // of hardware decoder buffers. Zero means tightly packed rows of the plane.
+        using plane_strides = std::array<int32_t, 3>;
+
         camera_utils() = delete;
 
-        static pixel_buffer_sptr full_image_to_pixel_buffer(bnb::full_image_t &image);
+        // Wraps the image planes without copying, padded rows are passed through as is
+        static pixel_buffer_sptr full_image_to_pixel_buffer(bnb::full_image_t &image, const plane_strides& strides = {});
+
+        // Copies the image into a buffer recycled from the pool instead of wrapping it, so the
+        // camera layer can reuse its frame right away and no per-frame allocation is made
+        static pixel_buffer_sptr full_image_to_pixel_buffer(bnb::full_image_t &image, const pixel_buffer_pool_sptr& pool, const plane_strides& strides = {});
     };
 
 } /* namespace bnb */
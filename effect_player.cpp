@@ -1,5 +1,10 @@
 #include "effect_player.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <optional>
 #include <iostream>
@@ -24,6 +29,125 @@ namespace bnb::oep
 
 } /* namespace bnb::oep */
 
+namespace
+{
+
+    using frame_descriptor = bnb::oep::effect_player::frame_descriptor;
+    using image_format = bnb::oep::interfaces::image_format;
+
+    frame_descriptor make_frame_descriptor(image_format format)
+    {
+        frame_descriptor descriptor;
+        auto& yuv = descriptor.yuv_format;
+
+        using ns = bnb::oep::interfaces::image_format;
+        switch (format) {
+            case ns::bpc8_rgb:
+                descriptor.layout = frame_descriptor::plane_layout::bpc8;
+                break;
+            case ns::bpc8_bgr:
+                descriptor.layout = frame_descriptor::plane_layout::bpc8;
+                descriptor.pixel_format = bnb::interfaces::pixel_format::bgr;
+                break;
+            case ns::bpc8_rgba:
+                descriptor.layout = frame_descriptor::plane_layout::bpc8;
+                descriptor.pixel_format = bnb::interfaces::pixel_format::rgba;
+                break;
+            case ns::bpc8_bgra:
+                descriptor.layout = frame_descriptor::plane_layout::bpc8;
+                descriptor.pixel_format = bnb::interfaces::pixel_format::bgra;
+                break;
+            case ns::bpc8_argb:
+                descriptor.layout = frame_descriptor::plane_layout::bpc8;
+                descriptor.pixel_format = bnb::interfaces::pixel_format::argb;
+                break;
+            case ns::nv12_bt601_full:
+                descriptor.layout = frame_descriptor::plane_layout::nv12;
+                break;
+            case ns::nv12_bt601_video:
+                descriptor.layout = frame_descriptor::plane_layout::nv12;
+                yuv.range = bnb::color_range::video;
+                break;
+            case ns::nv12_bt709_full:
+                descriptor.layout = frame_descriptor::plane_layout::nv12;
+                yuv.standard = bnb::color_std::bt709;
+                break;
+            case ns::nv12_bt709_video:
+                descriptor.layout = frame_descriptor::plane_layout::nv12;
+                yuv.range = bnb::color_range::video;
+                yuv.standard = bnb::color_std::bt709;
+                break;
+            case ns::i420_bt601_full:
+                descriptor.layout = frame_descriptor::plane_layout::i420;
+                yuv.format = bnb::yuv_format::yuv_i420;
+                break;
+            case ns::i420_bt601_video:
+                descriptor.layout = frame_descriptor::plane_layout::i420;
+                yuv.range = bnb::color_range::video;
+                yuv.format = bnb::yuv_format::yuv_i420;
+                break;
+            case ns::i420_bt709_full:
+                descriptor.layout = frame_descriptor::plane_layout::i420;
+                yuv.format = bnb::yuv_format::yuv_i420;
+                yuv.standard = bnb::color_std::bt709;
+                break;
+            case ns::i420_bt709_video:
+                descriptor.layout = frame_descriptor::plane_layout::i420;
+                yuv.range = bnb::color_range::video;
+                yuv.format = bnb::yuv_format::yuv_i420;
+                yuv.standard = bnb::color_std::bt709;
+                break;
+            // No default, so a format added to the OEP is reported by -Wswitch here
+        }
+        return descriptor;
+    }
+
+    // Every OEP format in the order of its value, the table below is indexed by the value
+    constexpr image_format all_image_formats[] = {
+        image_format::bpc8_rgb,
+        image_format::bpc8_bgr,
+        image_format::bpc8_rgba,
+        image_format::bpc8_bgra,
+        image_format::bpc8_argb,
+        image_format::nv12_bt601_full,
+        image_format::nv12_bt601_video,
+        image_format::nv12_bt709_full,
+        image_format::nv12_bt709_video,
+        image_format::i420_bt601_full,
+        image_format::i420_bt601_video,
+        image_format::i420_bt709_full,
+        image_format::i420_bt709_video,
+    };
+
+    constexpr size_t image_formats_count = std::size(all_image_formats);
+
+    constexpr bool is_numbered_from_zero(const image_format (&formats)[image_formats_count])
+    {
+        for (size_t i = 0; i < image_formats_count; ++i) {
+            if (static_cast<size_t>(formats[i]) != i) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(is_numbered_from_zero(all_image_formats), "OEP image formats must be numbered contiguously from zero");
+
+    std::array<frame_descriptor, image_formats_count> make_frame_descriptors()
+    {
+        std::array<frame_descriptor, image_formats_count> descriptors;
+        for (auto format : all_image_formats) {
+            descriptors[static_cast<size_t>(format)] = make_frame_descriptor(format);
+        }
+        return descriptors;
+    }
+
+    // Indexed by the OEP format, so push_frame() takes the SDK description with a single lookup
+    const std::array<frame_descriptor, image_formats_count> frame_descriptors = make_frame_descriptors();
+    const frame_descriptor unsupported_frame_descriptor;
+
+} /* namespace */
+
 namespace bnb::oep
 {
 
@@ -51,6 +175,7 @@ namespace bnb::oep
             width, // fx_width - the effect's framebuffer width
             height // fx_height - the effect's framebuffer height
             )))
+        , m_effect_manager(m_ep->effect_manager())
     {
         // Disable future filter. See method description for details.
         m_ep->set_recognizer_use_future_filter(false);
@@ -74,10 +199,11 @@ namespace bnb::oep
     void effect_player::surface_changed(int32_t width, int32_t height)
     {
         m_ep->surface_changed(width, height);
-        // Set explicitly the framebuffer of Effect Player to sync with surface size
-        if (auto em = m_ep->effect_manager()) {
-            em->set_effect_size(width, height);
-        }
+        m_surface_width = width;
+        m_surface_height = height;
+        // Set explicitly the framebuffer of Effect Player to sync with surface size,
+        // scaled down if the effect does not keep up with the target frame rate
+        apply_effect_size();
     }
 
     /* effect_player::surface_destroyed */
@@ -89,8 +215,20 @@ namespace bnb::oep
     /* effect_player::load_effect */
     bool effect_player::load_effect(const std::string& effect)
     {
-        if (auto effect_manager = m_ep->effect_manager()) {
-            effect_manager->load(effect);
+        // Calls queued so far are meant for the current effect
+        flush_js_commands();
+        if (m_effect_manager) {
+            auto start = std::chrono::steady_clock::now();
+            m_effect_manager->load(effect);
+            m_has_effect = true;
+            if (m_preloader) {
+                m_preloader->on_effect_loaded(effect, std::chrono::steady_clock::now() - start);
+            }
+            // Another effect has another cost, the scale is chosen again from the full size
+            if (m_scale_controller.is_enabled()) {
+                m_scale_controller.reset();
+                apply_effect_size();
+            }
             return true;
         }
         return false;
@@ -99,34 +237,52 @@ namespace bnb::oep
     /* effect_player::call_js_method */
     bool effect_player::call_js_method(const std::string& method, const std::string& param)
     {
-        if (auto e_manager = m_ep->effect_manager()) {
-            if (auto effect = e_manager->current()) {
-                effect->call_js_method(method, param);
-            } else {
-                std::cout << "[Error] effect not loaded" << std::endl;
-                return false;
-            }
-        } else {
-            std::cout << "[Error] effect manager not initialized" << std::endl;
+        // The call itself waits for the next frame, see js_command_queue, but the result still tells
+        // whether there is an effect to call. Known from the last load or frame, not asked per call.
+        if (!m_has_effect) {
             return false;
         }
+        m_js_queue.push_method(method, param);
         return true;
     }
 
     /* effect_player::eval_js */
     void effect_player::eval_js(const std::string& script, oep_eval_js_result_cb result_callback)
     {
-        if (auto e_manager = m_ep->effect_manager()) {
-            if (auto effect = e_manager->current()) {
-                std::shared_ptr<bnb::oep::js_callback> callback
-                    = result_callback ? std::make_shared<bnb::oep::js_callback>(std::move(result_callback)) : nullptr;
-                effect->eval_js(script, callback);
+        m_js_queue.push_script(script, std::move(result_callback));
+    }
+
+    /* effect_player::flush_js_commands */
+    void effect_player::flush_js_commands()
+    {
+        // Without an effect known the query is made every frame, an effect may also be activated
+        // from JS or by the SDK itself
+        if (m_js_queue.empty() && m_has_effect) {
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto effect = m_effect_manager ? m_effect_manager->current() : nullptr;
+        m_has_effect = effect != nullptr;
+        if (m_js_queue.empty()) {
+            return;
+        }
+        auto commands = m_js_queue.take();
+        if (!effect) {
+            std::cout << "[Error] effect not loaded, " << commands.size() << " JS calls dropped" << std::endl;
+            return;
+        }
+        // One call per command, so a command failing in JS does not skip the others
+        for (auto& c : commands) {
+            if (!c.method.empty()) {
+                effect->call_js_method(c.method, c.param);
             } else {
-                std::cout << "[Error] effect not loaded" << std::endl;
+                std::shared_ptr<bnb::oep::js_callback> callback
+                    = c.callback ? std::make_shared<bnb::oep::js_callback>(std::move(c.callback)) : nullptr;
+                effect->eval_js(c.script, callback);
             }
-        } else {
-            std::cout << "[Error] effect manager not initialized" << std::endl;
         }
+        m_js_queue.on_evaluated(commands.size(), std::chrono::steady_clock::now() - start);
     }
 
     /* effect_player::pause */
@@ -150,44 +306,44 @@ namespace bnb::oep
     /* effect_player::push_frame */
     void effect_player::push_frame(pixel_buffer_sptr image, bnb::oep::interfaces::rotation image_orientation, bool require_mirroring)
     {
-        using ns = bnb::oep::interfaces::image_format;
+        auto frame = bnb::trace::find(image.get());
+        bnb::trace::record(frame, bnb::trace::stage::push_frame);
+        m_last_pushed_frame = frame;
+
+        image = pack_padded_rows(std::move(image));
+        if (image == nullptr) {
+            return;
+        }
+
+        using layout = frame_descriptor::plane_layout;
+        const auto& descriptor = get_frame_descriptor(image->get_image_format());
         auto bnb_image_format = make_bnb_image_format(image, image_orientation, require_mirroring);
-        switch (image->get_image_format()) {
-            case ns::bpc8_rgb:
-            case ns::bpc8_bgr:
-            case ns::bpc8_rgba:
-            case ns::bpc8_bgra:
-            case ns::bpc8_argb:
+        switch (descriptor.layout) {
+            case layout::bpc8:
                 m_ep->push_frame(
                     full_image_t(bpc8_image_t(
                         color_plane(image->get_base_sptr()),
-                        make_bnb_pixel_format(image),
+                        descriptor.pixel_format,
                         bnb_image_format)));
                 break;
-            case ns::nv12_bt601_full:
-            case ns::nv12_bt601_video:
-            case ns::nv12_bt709_full:
-            case ns::nv12_bt709_video:
+            case layout::nv12:
                 m_ep->push_frame(
                     full_image_t(yuv_image_t(
                         color_plane(image->get_base_sptr_of_plane(0)),
                         color_plane(image->get_base_sptr_of_plane(1)),
                         bnb_image_format,
-                        make_bnb_yuv_format(image))));
+                        descriptor.yuv_format)));
                 break;
-            case ns::i420_bt601_full:
-            case ns::i420_bt601_video:
-            case ns::i420_bt709_full:
-            case ns::i420_bt709_video:
+            case layout::i420:
                 m_ep->push_frame(
                     full_image_t(yuv_image_t(
                         color_plane(image->get_base_sptr_of_plane(0)),
                         color_plane(image->get_base_sptr_of_plane(1)),
                         color_plane(image->get_base_sptr_of_plane(2)),
                         bnb_image_format,
-                        make_bnb_yuv_format(image))));
+                        descriptor.yuv_format)));
                 break;
-            default:
+            case layout::unsupported:
                 break;
         }
     }
@@ -195,7 +351,37 @@ namespace bnb::oep
     /* effect_player::draw */
     int64_t effect_player::draw()
     {
-        return m_ep->draw();
+        auto frame = m_last_pushed_frame.load();
+        bnb::trace::record(frame, bnb::trace::stage::draw_begin);
+        // JS calls made since the previous frame take effect in this one
+        flush_js_commands();
+        auto start = std::chrono::steady_clock::now();
+        auto drawn = m_ep->draw();
+        auto draw_time = std::chrono::steady_clock::now() - start;
+        bnb::trace::record(frame, bnb::trace::stage::draw_end);
+
+        // Draw calls without a new frame return -1 and take no time, they are not accounted.
+        // Changes are reported by get_scale_statistics().
+        if (drawn >= 0 && m_scale_controller.on_frame_drawn(draw_time)) {
+            apply_effect_size();
+        }
+        return drawn;
+    }
+
+    /* effect_player::apply_effect_size */
+    void effect_player::apply_effect_size()
+    {
+        int32_t width = m_surface_width;
+        int32_t height = m_surface_height;
+        if (width <= 0 || height <= 0) {
+            return;
+        }
+        auto scale = m_scale_controller.get_scale();
+        // Even sizes keep the chroma of YUV input aligned with the luma
+        auto scaled = [scale](int32_t size) { return std::max(2, static_cast<int32_t>(std::lround(size * scale / 2.0)) * 2); };
+        if (m_effect_manager) {
+            m_effect_manager->set_effect_size(scale < 1.0 ? scaled(width) : width, scale < 1.0 ? scaled(height) : height);
+        }
     }
 
     /* effect_player::make_bnb_image_format */
@@ -222,75 +408,57 @@ namespace bnb::oep
         return {static_cast<uint32_t>(image->get_width()), static_cast<uint32_t>(image->get_height()), camera_orient, require_mirroring, 0, std::nullopt};
     }
 
+    /* effect_player::get_frame_descriptor */
+    const effect_player::frame_descriptor& effect_player::get_frame_descriptor(interfaces::image_format format)
+    {
+        auto index = static_cast<size_t>(format);
+        return index < frame_descriptors.size() ? frame_descriptors[index] : unsupported_frame_descriptor;
+    }
+
     /* effect_player::make_bnb_yuv_format */
     bnb::yuv_format_t effect_player::make_bnb_yuv_format(pixel_buffer_sptr image)
     {
-        bnb::yuv_format format {bnb::yuv_format::yuv_nv12};  /* i.e. NV12 or I420 */
-        bnb::color_std standard {bnb::color_std::bt601}; /* i.e. BT.601 or BT.709 */
-        bnb::color_range range {bnb::color_range::full}; /* i.e. "full" or "video" */
-
-        using ns = bnb::oep::interfaces::image_format;
-        switch (image->get_image_format()) {
-            case ns::nv12_bt601_full:
-                break;
-            case ns::nv12_bt601_video:
-                range = bnb::color_range::video;
-                break;
-            case ns::nv12_bt709_full:
-                standard = bnb::color_std::bt709;
-                break;
-            case ns::nv12_bt709_video:
-                range = bnb::color_range::video;
-                standard = bnb::color_std::bt709;
-                break;
-            case ns::i420_bt601_full:
-                format = bnb::yuv_format::yuv_i420;
-                break;
-            case ns::i420_bt601_video:
-                range = bnb::color_range::video;
-                format = bnb::yuv_format::yuv_i420;
-                break;
-            case ns::i420_bt709_full:
-                format = bnb::yuv_format::yuv_i420;
-                standard = bnb::color_std::bt709;
-                break;
-            case ns::i420_bt709_video:
-                range = bnb::color_range::video;
-                format = bnb::yuv_format::yuv_i420;
-                standard = bnb::color_std::bt709;
-                break;
-            default:
-                break;
-        }
-
-        return {range, standard, format};
+        return get_frame_descriptor(image->get_image_format()).yuv_format;
     }
 
     /* effect_player::make_bnb_pixel_format */
     bnb::interfaces::pixel_format effect_player::make_bnb_pixel_format(pixel_buffer_sptr image)
     {
-        bnb::interfaces::pixel_format fmt {bnb::interfaces::pixel_format::rgb};
+        return get_frame_descriptor(image->get_image_format()).pixel_format;
+    }
 
-        using ns = bnb::oep::interfaces::image_format;
-        switch (image->get_image_format()) {
-            case ns::bpc8_rgb:
-                break;
-            case ns::bpc8_bgr:
-                fmt = bnb::interfaces::pixel_format::bgr;
-                break;
-            case ns::bpc8_rgba:
-                fmt = bnb::interfaces::pixel_format::rgba;
-                break;
-            case ns::bpc8_bgra:
-                fmt = bnb::interfaces::pixel_format::bgra;
-                break;
-            case ns::bpc8_argb:
-                fmt = bnb::interfaces::pixel_format::argb;
-                break;
-            default:
-                break;
+    /* effect_player::pack_padded_rows */
+    pixel_buffer_sptr effect_player::pack_padded_rows(pixel_buffer_sptr image)
+    {
+        // The SDK image types have no row pitch, so frames with padded rows (e.g. from hardware
+        // decoders) are packed here. Tightly packed frames are passed through without copying.
+        auto format = image->get_image_format();
+        auto width = image->get_width();
+        auto height = image->get_height();
+        auto planes_count = get_planes_count(format);
+
+        bool is_padded = false;
+        for (int32_t plane = 0; plane < planes_count; ++plane) {
+            is_padded |= image->get_bytes_per_row_of_plane(plane) != get_plane_geometry(format, plane, width, height).row_size;
+        }
+        if (!is_padded) {
+            return image;
+        }
+
+        auto packed = m_packed_frames_pool->acquire(format, width, height);
+        if (packed == nullptr) {
+            return nullptr;
+        }
+        for (int32_t plane = 0; plane < planes_count; ++plane) {
+            auto geometry = get_plane_geometry(format, plane, width, height);
+            auto src_stride = image->get_bytes_per_row_of_plane(plane);
+            auto src = image->get_base_sptr_of_plane(plane).get();
+            auto dst = packed->get_base_sptr_of_plane(plane).get();
+            for (int32_t row = 0; row < geometry.rows; ++row) {
+                std::memcpy(dst + static_cast<size_t>(row) * geometry.row_size, src + static_cast<size_t>(row) * src_stride, geometry.row_size);
+            }
         }
-        return fmt;
+        return packed;
     }
 
 } /* namespace bnb::oep */
@@ -3,6 +3,12 @@
 #include <interfaces/effect_player.hpp>
 #include <bnb/effect_player/interfaces/all.hpp>
 
+#include "effect_preloader.hpp"
+#include "effect_scale_controller.hpp"
+#include "js_command_queue.hpp"
+#include "libraries/pixel_buffer_pool/pixel_buffer_pool.hpp"
+#include "libraries/trace/frame_trace.hpp"
+
 namespace bnb::oep
 {
 
@@ -35,14 +41,72 @@ namespace bnb::oep
 
         int64_t draw() override;
 
+        // SDK description of an OEP pixel format, prepared once for every format
+        struct frame_descriptor
+        {
+            enum class plane_layout
+            {
+                unsupported,
+                bpc8,
+                nv12,
+                i420
+            };
+
+            plane_layout layout {plane_layout::unsupported};
+            bnb::interfaces::pixel_format pixel_format {bnb::interfaces::pixel_format::rgb};
+            bnb::yuv_format_t yuv_format {bnb::color_range::full, bnb::color_std::bt601, bnb::yuv_format::yuv_nv12};
+        };
+
+        static const frame_descriptor& get_frame_descriptor(interfaces::image_format format);
+
+        // Descriptions of OEP pixel buffers in terms of the SDK image types
+        static bnb::image_format make_bnb_image_format(pixel_buffer_sptr image, interfaces::rotation orientation, bool require_mirroring);
+        static bnb::yuv_format_t make_bnb_yuv_format(pixel_buffer_sptr image);
+        static bnb::interfaces::pixel_format make_bnb_pixel_format(pixel_buffer_sptr image);
+
+        // Load times of effects are reported to the preloader, which keeps their files warm
+        void set_effect_preloader(effect_preloader_sptr preloader)
+        {
+            m_preloader = std::move(preloader);
+        }
+
+        // Queue depth and time spent in JS per frame, see js_command_queue
+        js_command_queue::statistics get_js_statistics() const
+        {
+            return m_js_queue.get_statistics();
+        }
+
+        // Scale of the effect framebuffer chosen from draw times, see effect_scale_controller
+        effect_scale_controller::statistics get_scale_statistics() const
+        {
+            return m_scale_controller.get_statistics();
+        }
+
     private:
-        bnb::image_format make_bnb_image_format(pixel_buffer_sptr image, interfaces::rotation orientation, bool require_mirroring);
-        bnb::yuv_format_t make_bnb_yuv_format(pixel_buffer_sptr image);
-        bnb::interfaces::pixel_format make_bnb_pixel_format(pixel_buffer_sptr image);
+        pixel_buffer_sptr pack_padded_rows(pixel_buffer_sptr image);
+
+        // Makes the JS calls queued since the previous frame
+        void flush_js_commands();
+
+        // Sets the effect framebuffer to the surface size multiplied by the current scale
+        void apply_effect_size();
 
     private:
         std::shared_ptr<bnb::interfaces::effect_player> m_ep;
+        // Taken once instead of on every call, used on the render thread only
+        std::shared_ptr<bnb::interfaces::effect_manager> m_effect_manager;
         std::atomic_bool m_is_surface_created {false};
+        // Whether the SDK had a current effect at the last load or JS flush, checked by call_js_method
+        // instead of querying the effect manager on the caller's thread
+        std::atomic_bool m_has_effect {false};
+        pixel_buffer_pool_sptr m_packed_frames_pool {pixel_buffer_pool::create()};
+        // Traced id of the latest pushed frame, the one draw() renders
+        std::atomic<bnb::trace::frame_id> m_last_pushed_frame {bnb::trace::no_frame};
+        effect_preloader_sptr m_preloader;
+        js_command_queue m_js_queue;
+        effect_scale_controller m_scale_controller;
+        std::atomic<int32_t> m_surface_width {0};
+        std::atomic<int32_t> m_surface_height {0};
     }; /* class effect_player */
 
 } /* namespace bnb::oep */
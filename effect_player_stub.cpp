@@ -0,0 +1,400 @@
+#include "effect_player_stub.hpp"
+
+#include "libraries/trace/frame_trace.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+
+    using image_format = bnb::oep::interfaces::image_format;
+
+    // Matches the values of uLayout in the fragment shader
+    enum class plane_layout : GLint
+    {
+        packed_rgb = 0,
+        nv12 = 1,
+        i420 = 2
+    };
+
+    int32_t read_environment(const char* name, int32_t fallback)
+    {
+        if (auto value = std::getenv(name)) {
+            return std::max(0, std::atoi(value));
+        }
+        return fallback;
+    }
+
+    plane_layout get_plane_layout(image_format format)
+    {
+        switch (format) {
+            case image_format::nv12_bt601_full:
+            case image_format::nv12_bt601_video:
+            case image_format::nv12_bt709_full:
+            case image_format::nv12_bt709_video:
+                return plane_layout::nv12;
+            case image_format::i420_bt601_full:
+            case image_format::i420_bt601_video:
+            case image_format::i420_bt709_full:
+            case image_format::i420_bt709_video:
+                return plane_layout::i420;
+            default:
+                return plane_layout::packed_rgb;
+        }
+    }
+
+} /* namespace */
+
+namespace bnb::oep
+{
+
+    /* effect_player::create */
+    effect_player_sptr interfaces::effect_player::create(int32_t width, int32_t height)
+    {
+        return std::make_shared<bnb::oep::effect_player_stub>(width, height, effect_player_stub::workload_from_environment());
+    }
+
+    /* effect_player_stub::workload_from_environment */
+    effect_player_stub::workload effect_player_stub::workload_from_environment()
+    {
+        workload load;
+        load.draw_passes = std::max(1, read_environment("BNB_STUB_DRAW_PASSES", load.draw_passes));
+        load.fragment_iterations = read_environment("BNB_STUB_FRAGMENT_ITERATIONS", load.fragment_iterations);
+        load.load_delay = std::chrono::milliseconds(read_environment("BNB_STUB_LOAD_DELAY_MS", static_cast<int32_t>(load.load_delay.count())));
+        return load;
+    }
+
+    /* effect_player_stub::effect_player_stub CONSTRUCTOR */
+    effect_player_stub::effect_player_stub(int32_t width, int32_t height, const workload& load)
+        : m_workload(load)
+        , m_width(width)
+        , m_height(height)
+    {
+        std::cout << "[INFO] Stub effect player: " << m_workload.draw_passes << " passes of "
+                  << m_workload.fragment_iterations << " iterations per frame" << std::endl;
+    }
+
+    /* effect_player_stub::~effect_player_stub */
+    effect_player_stub::~effect_player_stub()
+    {
+    }
+
+    /* effect_player_stub::surface_created */
+    void effect_player_stub::surface_created(int32_t width, int32_t height)
+    {
+        surface_changed(width, height);
+    }
+
+    /* effect_player_stub::surface_changed */
+    void effect_player_stub::surface_changed(int32_t width, int32_t height)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_width = width;
+        m_height = height;
+    }
+
+    /* effect_player_stub::surface_destroyed */
+    void effect_player_stub::surface_destroyed()
+    {
+        release();
+    }
+
+    /* effect_player_stub::load_effect */
+    bool effect_player_stub::load_effect(const std::string& effect)
+    {
+        std::chrono::milliseconds delay;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            delay = m_workload.load_delay;
+        }
+        if (delay.count() > 0) {
+            std::this_thread::sleep_for(delay);
+        }
+        std::cout << "[INFO] Stub effect player: " << effect << " loaded" << std::endl;
+        return true;
+    }
+
+    /* effect_player_stub::call_js_method */
+    bool effect_player_stub::call_js_method(const std::string& method, const std::string& param)
+    {
+        return true;
+    }
+
+    /* effect_player_stub::eval_js */
+    void effect_player_stub::eval_js(const std::string& script, oep_eval_js_result_cb result_callback)
+    {
+        if (result_callback) {
+            result_callback("");
+        }
+    }
+
+    /* effect_player_stub::pause */
+    void effect_player_stub::pause()
+    {
+        m_is_paused = true;
+    }
+
+    /* effect_player_stub::resume */
+    void effect_player_stub::resume()
+    {
+        m_is_paused = false;
+    }
+
+    /* effect_player_stub::stop */
+    void effect_player_stub::stop()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frame = nullptr;
+    }
+
+    /* effect_player_stub::push_frame */
+    void effect_player_stub::push_frame(pixel_buffer_sptr image, bnb::oep::interfaces::rotation image_orientation, bool require_mirroring)
+    {
+        auto trace_frame = bnb::trace::find(image.get());
+        bnb::trace::record(trace_frame, bnb::trace::stage::push_frame);
+
+        // Like the SDK, only keep the frame here, it is uploaded by draw() with the context current
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frame = std::move(image);
+        m_mirror = require_mirroring;
+        m_trace_frame = trace_frame;
+    }
+
+    /* effect_player_stub::draw */
+    int64_t effect_player_stub::draw()
+    {
+        pixel_buffer_sptr frame;
+        bool mirror = false;
+        uint64_t trace_frame = 0;
+        int32_t width = 0;
+        int32_t height = 0;
+        workload load;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_frame == nullptr || m_is_paused) {
+                return -1;
+            }
+            frame = std::move(m_frame);
+            mirror = m_mirror;
+            trace_frame = m_trace_frame;
+            width = m_width;
+            height = m_height;
+            load = m_workload;
+        }
+
+        bnb::trace::record(trace_frame, bnb::trace::stage::draw_begin);
+        if (m_program == nullptr) {
+            initialize();
+        }
+        upload_planes(frame);
+
+        m_program->use();
+        glUniform1i(m_layout_location, static_cast<GLint>(get_plane_layout(frame->get_image_format())));
+        glUniform1i(m_iterations_location, load.fragment_iterations);
+        glUniform1i(m_mirror_location, mirror ? 1 : 0);
+        for (size_t i = 0; i < m_planes.size(); ++i) {
+            glActiveTexture(GLenum(GL_TEXTURE0 + i));
+            glBindTexture(GL_TEXTURE_2D, m_planes[i].texture);
+        }
+
+        glViewport(0, 0, width, height);
+        glDisable(GL_BLEND);
+        glBindVertexArray(m_vao);
+        for (int32_t pass = 0; pass < load.draw_passes; ++pass) {
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        m_program->unuse();
+        bnb::trace::record(trace_frame, bnb::trace::stage::draw_end);
+
+        return ++m_drawn_frames;
+    }
+
+    /* effect_player_stub::set_workload */
+    void effect_player_stub::set_workload(const workload& load)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_workload = load;
+    }
+
+    /* effect_player_stub::initialize */
+    void effect_player_stub::initialize()
+    {
+        // clang-format off
+        static const char* vertex_shader_program =
+            "precision highp float;\n"
+            "layout (location = 0) in vec2 aPos;\n"
+            "uniform int uMirror;\n"
+            "out vec2 vTexCoord;\n"
+            "void main() {\n"
+            "  gl_Position = vec4(aPos, 0.0, 1.0);\n"
+            "  vTexCoord = vec2(uMirror != 0 ? 1.0 - (aPos.x + 1.0) * 0.5 : (aPos.x + 1.0) * 0.5, (1.0 - aPos.y) * 0.5);\n"
+            "}\n";
+
+        // The loop stands in for the cost of an effect, its result only slightly tints the frame
+        // so the output stays recognizable while the compiler cannot drop the work
+        static const char* fragment_shader_program =
+            "precision highp float;\n"
+            "in vec2 vTexCoord;\n"
+            "out vec4 FragColor;\n"
+            "uniform sampler2D uPlane0;\n"
+            "uniform sampler2D uPlane1;\n"
+            "uniform sampler2D uPlane2;\n"
+            "uniform int uLayout;\n"
+            "uniform int uIterations;\n"
+            "void main() {\n"
+            "  vec3 rgb;\n"
+            "  if (uLayout == 0) {\n"
+            "    rgb = texture(uPlane0, vTexCoord).rgb;\n"
+            "  } else {\n"
+            "    float y = texture(uPlane0, vTexCoord).r;\n"
+            "    vec2 uv = uLayout == 1 ? texture(uPlane1, vTexCoord).rg : vec2(texture(uPlane1, vTexCoord).r, texture(uPlane2, vTexCoord).r);\n"
+            "    uv -= vec2(0.5);\n"
+            "    rgb = vec3(y + 1.402 * uv.y, y - 0.344 * uv.x - 0.714 * uv.y, y + 1.772 * uv.x);\n"
+            "  }\n"
+            "  vec3 acc = rgb;\n"
+            "  for (int i = 0; i < uIterations; ++i) {\n"
+            "    acc = fract(acc * 1.618 + sin(acc.zxy * 3.14159));\n"
+            "  }\n"
+            "  FragColor = vec4(mix(rgb, acc, 0.02), 1.0);\n"
+            "}\n";
+
+        static const float drawing_plane_coords[] = {
+            -1.0f, -1.0f,
+            1.0f, -1.0f,
+            -1.0f, 1.0f,
+            1.0f, 1.0f,
+        };
+        // clang-format on
+
+        m_program = std::make_unique<bnb::oep::program>("effect_player_stub", vertex_shader_program, fragment_shader_program);
+
+        m_program->use();
+        GLint program_id = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program_id);
+        m_layout_location = glGetUniformLocation(program_id, "uLayout");
+        m_iterations_location = glGetUniformLocation(program_id, "uIterations");
+        m_mirror_location = glGetUniformLocation(program_id, "uMirror");
+        glUniform1i(glGetUniformLocation(program_id, "uPlane0"), 0);
+        glUniform1i(glGetUniformLocation(program_id, "uPlane1"), 1);
+        glUniform1i(glGetUniformLocation(program_id, "uPlane2"), 2);
+        m_program->unuse();
+
+        glGenVertexArrays(1, &m_vao);
+        glGenBuffers(1, &m_vbo);
+        glBindVertexArray(m_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(drawing_plane_coords), drawing_plane_coords, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    /* effect_player_stub::release */
+    void effect_player_stub::release()
+    {
+        for (auto& plane : m_planes) {
+            if (plane.texture != 0) {
+                glDeleteTextures(1, &plane.texture);
+            }
+            plane = {};
+        }
+        if (m_vao != 0) {
+            glDeleteVertexArrays(1, &m_vao);
+            m_vao = 0;
+        }
+        if (m_vbo != 0) {
+            glDeleteBuffers(1, &m_vbo);
+            m_vbo = 0;
+        }
+        m_program = nullptr;
+    }
+
+    /* effect_player_stub::upload_planes */
+    void effect_player_stub::upload_planes(const pixel_buffer_sptr& image)
+    {
+        auto width = image->get_width();
+        auto height = image->get_height();
+        auto chroma_width = (width + 1) / 2;
+        auto chroma_height = (height + 1) / 2;
+        auto plane = [&image](int32_t index) {
+            return image->get_base_sptr_of_plane(index).get();
+        };
+        auto stride = [&image](int32_t index) {
+            return image->get_bytes_per_row_of_plane(index);
+        };
+
+        switch (image->get_image_format()) {
+            case image_format::bpc8_rgb:
+                upload_plane(0, plane(0), stride(0), width, height, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3);
+                break;
+            case image_format::bpc8_bgr:
+                upload_plane(0, plane(0), stride(0), width, height, GL_RGB8, GL_BGR, GL_UNSIGNED_BYTE, 3);
+                break;
+            case image_format::bpc8_rgba:
+                upload_plane(0, plane(0), stride(0), width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4);
+                break;
+            case image_format::bpc8_bgra:
+                upload_plane(0, plane(0), stride(0), width, height, GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, 4);
+                break;
+            case image_format::bpc8_argb:
+                /* the packed type reads A,R,G,B bytes of a little endian word as B,G,R,A */
+                upload_plane(0, plane(0), stride(0), width, height, GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8, 4);
+                break;
+            case image_format::nv12_bt601_full:
+            case image_format::nv12_bt601_video:
+            case image_format::nv12_bt709_full:
+            case image_format::nv12_bt709_video:
+                upload_plane(0, plane(0), stride(0), width, height, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1);
+                upload_plane(1, plane(1), stride(1), chroma_width, chroma_height, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2);
+                break;
+            case image_format::i420_bt601_full:
+            case image_format::i420_bt601_video:
+            case image_format::i420_bt709_full:
+            case image_format::i420_bt709_video:
+                upload_plane(0, plane(0), stride(0), width, height, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1);
+                upload_plane(1, plane(1), stride(1), chroma_width, chroma_height, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1);
+                upload_plane(2, plane(2), stride(2), chroma_width, chroma_height, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1);
+                break;
+        }
+    }
+
+    /* effect_player_stub::upload_plane */
+    void effect_player_stub::upload_plane(size_t index, const uint8_t* data, int32_t bytes_per_row, int32_t width, int32_t height, GLenum internal_format, GLenum format, GLenum type, int32_t bytes_per_pixel)
+    {
+        auto& plane = m_planes[index];
+        if (plane.texture == 0) {
+            glGenTextures(1, &plane.texture);
+        }
+        glBindTexture(GL_TEXTURE_2D, plane.texture);
+        if (plane.internal_format != internal_format || plane.width != width || plane.height != height) {
+            glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            plane.internal_format = internal_format;
+            plane.width = width;
+            plane.height = height;
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (bytes_per_row % bytes_per_pixel == 0) {
+            /* padded rows are skipped by the driver */
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, bytes_per_row / bytes_per_pixel);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, data);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        } else {
+            for (int32_t row = 0; row < height; ++row) {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, width, 1, format, type, data + static_cast<size_t>(row) * bytes_per_row);
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+} /* namespace bnb::oep */
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <interfaces/effect_player.hpp>
+
+#include <glad/glad.h>
+#include <opengl/program.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace bnb::oep
+{
+
+    // Stand-in for the Banuba SDK effect player, selected with the BNB_STUB_EFFECT_PLAYER
+    // CMake option. It takes frames in every format the real one accepts and renders them
+    // with a synthetic, deterministic GPU workload, so the OEP queueing, the renderer and
+    // frame ingestion can be measured on machines without the SDK, e.g. CI boxes with llvmpipe.
+    class effect_player_stub : public bnb::oep::interfaces::effect_player
+    {
+    public:
+        struct workload
+        {
+            // Full screen passes per drawn frame
+            int32_t draw_passes {4};
+            // Arithmetic loop iterations per fragment and pass
+            int32_t fragment_iterations {32};
+            // load_effect blocks for this long, as parsing and compiling a real effect would
+            std::chrono::milliseconds load_delay {0};
+        };
+
+        // Defaults overridden with BNB_STUB_DRAW_PASSES, BNB_STUB_FRAGMENT_ITERATIONS
+        // and BNB_STUB_LOAD_DELAY_MS environment variables
+        static workload workload_from_environment();
+
+        effect_player_stub(int32_t width, int32_t height, const workload& load);
+
+        ~effect_player_stub();
+
+        void surface_created(int32_t width, int32_t height) override;
+
+        void surface_changed(int32_t width, int32_t height) override;
+
+        void surface_destroyed() override;
+
+        bool load_effect(const std::string& effect) override;
+
+        bool call_js_method(const std::string& method, const std::string& param) override;
+
+        void eval_js(const std::string& script, oep_eval_js_result_cb result_callback) override;
+
+        void pause() override;
+
+        void resume() override;
+
+        void stop() override;
+
+        void push_frame(pixel_buffer_sptr image, bnb::oep::interfaces::rotation image_orientation, bool require_mirroring) override;
+
+        int64_t draw() override;
+
+        void set_workload(const workload& load);
+
+    private:
+        struct plane_texture
+        {
+            GLuint texture {0};
+            GLenum internal_format {0};
+            int32_t width {0};
+            int32_t height {0};
+        };
+
+        void initialize();
+
+        void release();
+
+        void upload_planes(const pixel_buffer_sptr& image);
+
+        void upload_plane(size_t index, const uint8_t* data, int32_t bytes_per_row, int32_t width, int32_t height, GLenum internal_format, GLenum format, GLenum type, int32_t bytes_per_pixel);
+
+    private:
+        std::mutex m_mutex;
+        workload m_workload;
+        int32_t m_width;
+        int32_t m_height;
+
+        // The latest pushed frame, drawn on the next draw() call
+        pixel_buffer_sptr m_frame;
+        bool m_mirror {false};
+        uint64_t m_trace_frame {0};
+
+        std::atomic_bool m_is_paused {false};
+        int64_t m_drawn_frames {0};
+
+        std::unique_ptr<bnb::oep::program> m_program;
+        GLuint m_vao {0};
+        GLuint m_vbo {0};
+        std::array<plane_texture, 3> m_planes;
+        GLint m_layout_location {-1};
+        GLint m_iterations_location {-1};
+        GLint m_mirror_location {-1};
+    }; /* class effect_player_stub */
+
+} /* namespace bnb::oep */
@@ -0,0 +1,199 @@
+#include "effect_preloader.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace bnb
+{
+
+    /* effect_preloader::effect_preloader */
+    effect_preloader::effect_preloader(std::vector<std::string> resource_dirs, size_t warm_set_size)
+        : m_resource_dirs(std::move(resource_dirs))
+        , m_warm_set_size(warm_set_size)
+        , m_thread(&effect_preloader::worker, this)
+    {
+    }
+
+    /* effect_preloader::~effect_preloader */
+    effect_preloader::~effect_preloader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_is_stopped = true;
+            m_queue.clear();
+        }
+        m_queue_changed.notify_all();
+        m_thread.join();
+    }
+
+    /* effect_preloader::preload */
+    void effect_preloader::preload(const std::vector<std::string>& effects)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& effect : effects) {
+                if (std::find(m_queue.begin(), m_queue.end(), effect) == m_queue.end()) {
+                    m_queue.push_back(effect);
+                }
+            }
+        }
+        m_queue_changed.notify_all();
+    }
+
+    /* effect_preloader::wait */
+    void effect_preloader::wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queue_changed.wait(lock, [this]() { return m_is_stopped || (m_queue.empty() && !m_is_reading); });
+    }
+
+    /* effect_preloader::is_warm */
+    bool effect_preloader::is_warm(const std::string& effect) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_statistics.find(effect);
+        return it != m_statistics.end() && it->second.is_warm;
+    }
+
+    /* effect_preloader::on_effect_loaded */
+    void effect_preloader::on_effect_loaded(const std::string& effect, std::chrono::steady_clock::duration load_time)
+    {
+        auto load_ms = std::chrono::duration<double, std::milli>(load_time).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& s = m_statistics[effect];
+        s.average_load_ms = (s.average_load_ms * static_cast<double>(s.loads) + load_ms) / static_cast<double>(s.loads + 1);
+        ++s.loads;
+        s.last_load_ms = load_ms;
+        s.max_load_ms = std::max(s.max_load_ms, load_ms);
+        if (s.is_warm) {
+            ++s.warm_loads;
+            // The effect in use is the last one to be dropped from the cache
+            touch(effect);
+        }
+    }
+
+    /* effect_preloader::get_warm_bytes */
+    size_t effect_preloader::get_warm_bytes() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_warm_bytes;
+    }
+
+    /* effect_preloader::get_statistics */
+    effect_preloader::statistics effect_preloader::get_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    /* effect_preloader::effects_from_environment */
+    std::vector<std::string> effect_preloader::effects_from_environment()
+    {
+        std::vector<std::string> effects;
+        if (auto value = std::getenv("BNB_PRELOAD_EFFECTS")) {
+            std::istringstream stream(value);
+            std::string effect;
+            while (std::getline(stream, effect, ',')) {
+                if (!effect.empty()) {
+                    effects.push_back(effect);
+                }
+            }
+        }
+        return effects;
+    }
+
+    /* effect_preloader::worker */
+    void effect_preloader::worker()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_queue_changed.wait(lock, [this]() { return m_is_stopped || !m_queue.empty(); });
+            if (m_is_stopped) {
+                return;
+            }
+            auto effect = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_is_reading = true;
+            lock.unlock();
+
+            auto start = std::chrono::steady_clock::now();
+            auto bytes = read_effect_files(effect);
+            auto preload_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            if (bytes < 0) {
+                std::cout << "[ERROR] Effect " << effect << " not found, it is not preloaded" << std::endl;
+            } else {
+                auto& s = m_statistics[effect];
+                s.preload_ms = preload_ms;
+                if (s.is_warm) {
+                    m_warm_bytes -= s.bytes;
+                    m_warm_bytes += static_cast<size_t>(bytes);
+                }
+                s.bytes = static_cast<size_t>(bytes);
+                touch(effect);
+            }
+            m_is_reading = false;
+            m_queue_changed.notify_all();
+        }
+    }
+
+    /* effect_preloader::read_effect_files */
+    int64_t effect_preloader::read_effect_files(const std::string& effect) const
+    {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::path dir = effect;
+        if (!fs::is_directory(dir, ec)) {
+            auto it = std::find_if(m_resource_dirs.begin(), m_resource_dirs.end(), [&effect, &ec](const std::string& resources) {
+                return fs::is_directory(fs::path(resources) / effect, ec);
+            });
+            if (it == m_resource_dirs.end()) {
+                return -1;
+            }
+            dir = fs::path(*it) / effect;
+        }
+
+        // The contents are not kept, reading them is what brings them into the file cache
+        std::vector<char> chunk(1024 * 1024);
+        int64_t bytes = 0;
+        for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file(ec)) {
+                continue;
+            }
+            std::ifstream file(it->path(), std::ios::binary);
+            while (file.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || file.gcount() > 0) {
+                bytes += file.gcount();
+            }
+        }
+        return bytes;
+    }
+
+    /* effect_preloader::touch */
+    void effect_preloader::touch(const std::string& effect)
+    {
+        auto& s = m_statistics[effect];
+        auto it = std::find(m_lru.begin(), m_lru.end(), effect);
+        if (it != m_lru.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it);
+        } else {
+            m_lru.push_front(effect);
+            m_warm_bytes += s.bytes;
+            s.is_warm = true;
+        }
+
+        // The effect just used stays even if it alone exceeds the warm set size
+        while (m_warm_bytes > m_warm_set_size && m_lru.size() > 1) {
+            auto& evicted = m_statistics[m_lru.back()];
+            evicted.is_warm = false;
+            m_warm_bytes -= evicted.bytes;
+            m_lru.pop_back();
+        }
+    }
+
+} /* namespace bnb */
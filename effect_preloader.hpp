@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bnb
+{
+
+    class effect_preloader;
+    using effect_preloader_sptr = std::shared_ptr<effect_preloader>;
+
+    // Reads the files of effects the app is going to switch to on a background thread, so
+    // effect_manager::load() finds them in the OS file cache instead of waiting for the disk.
+    // Nothing is held in memory by the preloader: the file data goes to the OS page cache only,
+    // which the OS may evict at any time. The warm set is bookkeeping of the effects read last,
+    // an LRU list bounded by the total size of their files, which is the amount of effect data
+    // expected to stay cached. Dropping an effect from it frees no memory, it only makes the next
+    // preload() read the effect again. Load times reported by the effect player are collected per effect.
+    class effect_preloader
+    {
+    public:
+        // Total file size of the warm set, it bounds no real memory, see above
+        static constexpr size_t default_warm_set_size = 256 * 1024 * 1024;
+
+        struct effect_statistics
+        {
+            uint64_t loads {0};
+            // Loads of effects that were warm at the time
+            uint64_t warm_loads {0};
+            double last_load_ms {0.0};
+            double average_load_ms {0.0};
+            double max_load_ms {0.0};
+            // Time the last background read of the effect files took
+            double preload_ms {0.0};
+            size_t bytes {0};
+            bool is_warm {false};
+        };
+
+        using statistics = std::map<std::string, effect_statistics>;
+
+        // Effects are looked up as given and then relative to every resource directory
+        explicit effect_preloader(std::vector<std::string> resource_dirs, size_t warm_set_size = default_warm_set_size);
+
+        // Waits for the file being read, the rest of the queue is dropped
+        ~effect_preloader();
+
+        effect_preloader(const effect_preloader&) = delete;
+        effect_preloader& operator=(const effect_preloader&) = delete;
+
+        // Queues the effects for the background read, returns immediately
+        void preload(const std::vector<std::string>& effects);
+
+        // Blocks until the queued effects are read
+        void wait();
+
+        [[nodiscard]] bool is_warm(const std::string& effect) const;
+
+        // Called by the effect player after effect_manager::load() returned
+        void on_effect_loaded(const std::string& effect, std::chrono::steady_clock::duration load_time);
+
+        [[nodiscard]] size_t get_warm_bytes() const;
+
+        statistics get_statistics() const;
+
+        // Comma separated effect names of the BNB_PRELOAD_EFFECTS environment variable
+        static std::vector<std::string> effects_from_environment();
+
+    private:
+        void worker();
+
+        // Reads every file of the effect, returns the number of bytes or -1 if it is not found
+        int64_t read_effect_files(const std::string& effect) const;
+
+        // Moves the effect to the front of the LRU list and drops the tail above the warm set size,
+        // must be called with the mutex locked
+        void touch(const std::string& effect);
+
+    private:
+        const std::vector<std::string> m_resource_dirs;
+        const size_t m_warm_set_size;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_queue_changed;
+        std::deque<std::string> m_queue;
+        bool m_is_reading {false};
+        bool m_is_stopped {false};
+
+        // Warm effects, the most recently used first
+        std::list<std::string> m_lru;
+        size_t m_warm_bytes {0};
+        statistics m_statistics;
+
+        std::thread m_thread;
+    }; /* class effect_preloader */
+
+} /* namespace bnb */
@@ -0,0 +1,146 @@
+#include "effect_scale_controller.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+
+    double read_environment(const char* name, double fallback)
+    {
+        if (auto value = std::getenv(name)) {
+            return std::max(0.0, std::atof(value));
+        }
+        return fallback;
+    }
+
+} /* namespace */
+
+namespace bnb
+{
+
+    /* effect_scale_controller::config_from_environment */
+    effect_scale_controller::config effect_scale_controller::config_from_environment()
+    {
+        config cfg;
+        cfg.target_fps = read_environment("BNB_EFFECT_TARGET_FPS", cfg.target_fps);
+        cfg.min_scale = read_environment("BNB_EFFECT_MIN_SCALE", cfg.min_scale);
+        cfg.max_scale = read_environment("BNB_EFFECT_MAX_SCALE", cfg.max_scale);
+        return cfg;
+    }
+
+    /* effect_scale_controller::effect_scale_controller */
+    effect_scale_controller::effect_scale_controller(const config& cfg)
+        : m_config(sanitize(cfg))
+    {
+        m_scale = m_config.max_scale;
+        m_statistics.scale = m_scale;
+        m_statistics.min_scale_seen = m_scale;
+        m_statistics.frame_budget_ms = m_config.target_fps > 0.0 ? 1000.0 / m_config.target_fps : 0.0;
+    }
+
+    /* effect_scale_controller::on_frame_drawn */
+    bool effect_scale_controller::on_frame_drawn(std::chrono::steady_clock::duration draw_time)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_statistics.frames;
+        if (m_config.target_fps <= 0.0) {
+            return false;
+        }
+
+        m_window_draw_ms += std::chrono::duration<double, std::milli>(draw_time).count();
+        if (++m_window_frames < m_config.window_frames) {
+            return false;
+        }
+        auto average_ms = m_window_draw_ms / m_window_frames;
+        m_window_draw_ms = 0.0;
+        m_window_frames = 0;
+        if (m_skip_window) {
+            m_skip_window = false;
+            return false;
+        }
+        m_statistics.average_draw_ms = average_ms;
+
+        auto budget_ms = m_statistics.frame_budget_ms;
+        auto scale = m_scale;
+        if (average_ms > budget_ms && m_scale > m_config.min_scale) {
+            scale = std::max(m_config.min_scale, m_scale - m_config.scale_step);
+        } else if (m_scale < m_config.max_scale) {
+            auto larger = std::min(m_config.max_scale, m_scale + m_config.scale_step);
+            auto predicted_ms = average_ms * (larger * larger) / (m_scale * m_scale);
+            if (predicted_ms < budget_ms * m_config.upscale_headroom) {
+                scale = larger;
+            }
+        }
+        if (scale == m_scale) {
+            return false;
+        }
+
+        if (scale < m_scale) {
+            ++m_statistics.downscales;
+        } else {
+            ++m_statistics.upscales;
+        }
+        m_scale = scale;
+        m_statistics.scale = scale;
+        m_statistics.min_scale_seen = std::min(m_statistics.min_scale_seen, scale);
+        m_statistics.last_change_draw_ms = average_ms;
+        m_skip_window = true;
+        return true;
+    }
+
+    /* effect_scale_controller::is_enabled */
+    bool effect_scale_controller::is_enabled() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_config.target_fps > 0.0;
+    }
+
+    /* effect_scale_controller::get_scale */
+    double effect_scale_controller::get_scale() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_scale;
+    }
+
+    /* effect_scale_controller::reset */
+    void effect_scale_controller::reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_scale = m_config.max_scale;
+        m_statistics.scale = m_scale;
+        m_window_draw_ms = 0.0;
+        m_window_frames = 0;
+        m_skip_window = true;
+    }
+
+    /* effect_scale_controller::set_config */
+    void effect_scale_controller::set_config(const config& cfg)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_config = sanitize(cfg);
+        m_scale = std::clamp(m_scale, m_config.min_scale, m_config.max_scale);
+        m_statistics.scale = m_scale;
+        m_statistics.frame_budget_ms = m_config.target_fps > 0.0 ? 1000.0 / m_config.target_fps : 0.0;
+        m_window_draw_ms = 0.0;
+        m_window_frames = 0;
+    }
+
+    /* effect_scale_controller::get_statistics */
+    effect_scale_controller::statistics effect_scale_controller::get_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    /* effect_scale_controller::sanitize */
+    effect_scale_controller::config effect_scale_controller::sanitize(config cfg)
+    {
+        cfg.max_scale = std::clamp(cfg.max_scale, 0.1, 1.0);
+        cfg.min_scale = std::clamp(cfg.min_scale, 0.1, cfg.max_scale);
+        cfg.scale_step = std::max(0.01, cfg.scale_step);
+        cfg.window_frames = std::max(1, cfg.window_frames);
+        return cfg;
+    }
+
+} /* namespace bnb */
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace bnb
+{
+
+    // Picks the scale of the effect framebuffer relative to the surface from measured draw times,
+    // so a heavy effect keeps the target frame rate by rendering fewer pixels. Draw times are
+    // averaged over a window of frames; the scale goes down when the average exceeds the frame
+    // budget, and up only when the cost predicted for the larger framebuffer (it grows with the
+    // area) still fits in the budget with some headroom, so the scale does not oscillate.
+    //
+    // Only the CPU time of the draw is controlled. effect_player measures its call into the SDK,
+    // which submits the GL commands but does not wait for the GPU to execute them, so an effect
+    // bound by the GPU rather than by submission is not scaled down.
+    class effect_scale_controller
+    {
+    public:
+        struct config
+        {
+            // Zero disables the controller, the effect is then always rendered in the surface size
+            double target_fps {0.0};
+            double min_scale {0.5};
+            double max_scale {1.0};
+            double scale_step {0.1};
+            // Frames averaged before each decision
+            int32_t window_frames {30};
+            // Share of the frame budget the larger framebuffer is allowed to take when scaling up
+            double upscale_headroom {0.85};
+        };
+
+        struct statistics
+        {
+            double scale {1.0};
+            // Average draw time of the last complete window
+            double average_draw_ms {0.0};
+            double frame_budget_ms {0.0};
+            uint64_t frames {0};
+            uint64_t downscales {0};
+            uint64_t upscales {0};
+            // Smallest scale used so far and the average draw time the last change was made at
+            double min_scale_seen {1.0};
+            double last_change_draw_ms {0.0};
+        };
+
+        // Defaults overridden with BNB_EFFECT_TARGET_FPS, BNB_EFFECT_MIN_SCALE and
+        // BNB_EFFECT_MAX_SCALE environment variables
+        static config config_from_environment();
+
+        explicit effect_scale_controller(const config& cfg = config_from_environment());
+
+        // Accounts one drawn frame, returns true if the scale has changed
+        bool on_frame_drawn(std::chrono::steady_clock::duration draw_time);
+
+        [[nodiscard]] bool is_enabled() const;
+
+        [[nodiscard]] double get_scale() const;
+
+        // Starts over from the maximal scale, e.g. when another effect is loaded
+        void reset();
+
+        void set_config(const config& cfg);
+
+        statistics get_statistics() const;
+
+    private:
+        static config sanitize(config cfg);
+
+    private:
+        mutable std::mutex m_mutex;
+        config m_config;
+        double m_scale {1.0};
+        double m_window_draw_ms {0.0};
+        int32_t m_window_frames {0};
+        // The first window after a change is skipped, it includes reallocation of the framebuffer
+        bool m_skip_window {false};
+        statistics m_statistics;
+    }; /* class effect_scale_controller */
+
+} /* namespace bnb */
@@ -0,0 +1,211 @@
+#include "frame_file.hpp"
+
+#include "libraries/pixel_conversion/pixel_conversion.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace bnb
+{
+
+    using image_format = bnb::oep::interfaces::image_format;
+
+    /* frame_file_reader::frame_file_reader */
+    frame_file_reader::frame_file_reader(const std::string& path, pixel_buffer_pool_sptr pool)
+        : m_file(path, std::ios::binary)
+        , m_pool(pool ? std::move(pool) : pixel_buffer_pool::create())
+        , m_is_y4m(true)
+    {
+        if (!m_file) {
+            throw std::runtime_error("Unable to open " + path);
+        }
+        read_y4m_header();
+    }
+
+    /* frame_file_reader::frame_file_reader */
+    frame_file_reader::frame_file_reader(const std::string& path, bnb::oep::interfaces::image_format format, int32_t width, int32_t height, pixel_buffer_pool_sptr pool)
+        : m_file(path, std::ios::binary)
+        , m_pool(pool ? std::move(pool) : pixel_buffer_pool::create())
+        , m_format(format)
+        , m_width(width)
+        , m_height(height)
+    {
+        if (!m_file) {
+            throw std::runtime_error("Unable to open " + path);
+        }
+        if (get_planes_count(format) < 2) {
+            throw std::runtime_error("Only NV12 and I420 raw files are supported");
+        }
+        if (width <= 0 || height <= 0) {
+            throw std::runtime_error("Invalid raw frame size");
+        }
+    }
+
+    /* frame_file_reader::frame_file_reader */
+    frame_file_reader::frame_file_reader(const std::string& path, packed_yuv_layout layout, bool full_range, int32_t width, int32_t height, pixel_buffer_pool_sptr pool)
+        : m_file(path, std::ios::binary)
+        , m_pool(pool ? std::move(pool) : pixel_buffer_pool::create())
+        , m_packed_layout(layout)
+        , m_format(full_range ? image_format::nv12_bt601_full : image_format::nv12_bt601_video)
+        , m_width(width)
+        , m_height(height)
+    {
+        if (!m_file) {
+            throw std::runtime_error("Unable to open " + path);
+        }
+        if (width <= 0 || height <= 0 || width % 2 != 0) {
+            throw std::runtime_error("Invalid raw frame size, packed 4:2:2 frames must have an even width");
+        }
+        m_packed_frame.resize(static_cast<size_t>(width) * 2 * height);
+    }
+
+    /* frame_file_reader::read_frame */
+    pixel_buffer_sptr frame_file_reader::read_frame()
+    {
+        if (m_packed_layout.has_value()) {
+            return read_packed_frame();
+        }
+
+        if (m_is_y4m) {
+            std::string frame_header;
+            if (!std::getline(m_file, frame_header)) {
+                return nullptr;
+            }
+            if (frame_header.rfind("FRAME", 0) != 0) {
+                throw std::runtime_error("Corrupted Y4M frame header");
+            }
+        }
+
+        auto image = m_pool->acquire(m_format, m_width, m_height);
+        if (image == nullptr) {
+            return nullptr;
+        }
+
+        for (int32_t plane = 0; plane < image->get_number_of_planes(); ++plane) {
+            auto [row_size, rows] = get_plane_geometry(m_format, plane, m_width, m_height);
+            auto stride = image->get_bytes_per_row_of_plane(plane);
+            auto data = reinterpret_cast<char*>(image->get_base_sptr_of_plane(plane).get());
+
+            if (stride == row_size) {
+                m_file.read(data, static_cast<std::streamsize>(row_size) * rows);
+            } else {
+                for (int32_t row = 0; row < rows; ++row) {
+                    m_file.read(data + static_cast<size_t>(row) * stride, row_size);
+                }
+            }
+            if (!m_file) {
+                return nullptr;
+            }
+        }
+        return image;
+    }
+
+    /* frame_file_reader::read_packed_frame */
+    pixel_buffer_sptr frame_file_reader::read_packed_frame()
+    {
+        if (!m_file.read(reinterpret_cast<char*>(m_packed_frame.data()), static_cast<std::streamsize>(m_packed_frame.size()))) {
+            return nullptr;
+        }
+
+        auto image = m_pool->acquire(m_format, m_width, m_height);
+        if (image == nullptr) {
+            return nullptr;
+        }
+
+        const auto& kernels = conversion::get_kernels();
+        auto convert = *m_packed_layout == packed_yuv_layout::yuy2 ? kernels.yuy2_to_nv12 : kernels.uyvy_to_nv12;
+        convert(
+            m_packed_frame.data(),
+            m_width * 2,
+            image->get_base_sptr_of_plane(0).get(),
+            image->get_bytes_per_row_of_plane(0),
+            image->get_base_sptr_of_plane(1).get(),
+            image->get_bytes_per_row_of_plane(1),
+            m_width,
+            m_height);
+        return image;
+    }
+
+    /* frame_file_reader::read_y4m_header */
+    void frame_file_reader::read_y4m_header()
+    {
+        std::string header;
+        std::getline(m_file, header);
+        std::istringstream tokens(header);
+
+        std::string token;
+        tokens >> token;
+        if (token != "YUV4MPEG2") {
+            throw std::runtime_error("Not a Y4M file");
+        }
+
+        bool full_range = false;
+        while (tokens >> token) {
+            auto value = token.substr(1);
+            switch (token[0]) {
+                case 'W':
+                    m_width = std::stoi(value);
+                    break;
+                case 'H':
+                    m_height = std::stoi(value);
+                    break;
+                case 'F':
+                    if (auto separator = value.find(':'); separator != std::string::npos) {
+                        m_fps_numerator = std::stoi(value.substr(0, separator));
+                        m_fps_denominator = std::stoi(value.substr(separator + 1));
+                    }
+                    break;
+                case 'C':
+                    /* all 8-bit 4:2:0 chroma sitings share the I420 memory layout, C420p10 and
+                       the like have 16-bit samples */
+                    if (value != "420" && value != "420jpeg" && value != "420paldv" && value != "420mpeg2") {
+                        throw std::runtime_error("Only 8-bit 4:2:0 Y4M files are supported, got C" + value);
+                    }
+                    break;
+                case 'X':
+                    full_range = value == "COLORRANGE=FULL";
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (m_width <= 0 || m_height <= 0) {
+            throw std::runtime_error("Y4M header has no frame size");
+        }
+        m_format = full_range ? image_format::i420_bt601_full : image_format::i420_bt601_video;
+    }
+
+    /* y4m_file_writer::y4m_file_writer */
+    y4m_file_writer::y4m_file_writer(const std::string& path, int32_t width, int32_t height, int32_t fps_numerator, int32_t fps_denominator, bool full_range)
+        : m_file(path, std::ios::binary)
+        , m_width(width)
+        , m_height(height)
+    {
+        if (!m_file) {
+            throw std::runtime_error("Unable to create " + path);
+        }
+        m_file << "YUV4MPEG2 W" << width << " H" << height << " F" << fps_numerator << ":" << fps_denominator
+               << " Ip A1:1 C420jpeg XCOLORRANGE=" << (full_range ? "FULL" : "LIMITED") << "\n";
+    }
+
+    /* y4m_file_writer::write_frame */
+    void y4m_file_writer::write_frame(const pixel_buffer_sptr& image)
+    {
+        if (image->get_width() != m_width || image->get_height() != m_height || image->get_number_of_planes() != 3) {
+            throw std::runtime_error("Y4M writer expects I420 frames of the stream size");
+        }
+
+        m_file << "FRAME\n";
+        for (int32_t plane = 0; plane < 3; ++plane) {
+            auto width = plane == 0 ? m_width : (m_width + 1) / 2;
+            auto height = plane == 0 ? m_height : (m_height + 1) / 2;
+            auto stride = image->get_bytes_per_row_of_plane(plane);
+            auto data = image->get_base_sptr_of_plane(plane).get();
+            for (int32_t row = 0; row < height; ++row) {
+                m_file.write(reinterpret_cast<const char*>(data + static_cast<size_t>(row) * stride), width);
+            }
+        }
+    }
+
+} /* namespace bnb */
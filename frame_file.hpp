@@ -0,0 +1,104 @@
+#pragma once
+
+#include <interfaces/pixel_buffer.hpp>
+
+#include "libraries/pixel_buffer_pool/pixel_buffer_pool.hpp"
+
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace bnb
+{
+
+    // Reads 4:2:0 frames from Y4M files or from headerless raw NV12/I420/YUY2/UYVY files.
+    // Frames are read into buffers recycled from a pixel_buffer_pool.
+    class frame_file_reader
+    {
+    public:
+        // Layouts of packed 4:2:2 raw files, such frames are converted into NV12
+        enum class packed_yuv_layout
+        {
+            yuy2,
+            uyvy
+        };
+
+        // Opens an 8-bit 4:2:0 Y4M file, frame geometry and color range are taken from the stream header.
+        // A private pool is created if none is passed.
+        explicit frame_file_reader(const std::string& path, pixel_buffer_pool_sptr pool = nullptr);
+
+        // Opens a raw file of tightly packed NV12 or I420 frames of the given size
+        frame_file_reader(const std::string& path, bnb::oep::interfaces::image_format format, int32_t width, int32_t height, pixel_buffer_pool_sptr pool = nullptr);
+
+        // Opens a raw file of packed YUY2 or UYVY frames of the given size, the width must be even.
+        // The effect player does not accept 4:2:2 frames, so they are returned as NV12 of the given range.
+        frame_file_reader(const std::string& path, packed_yuv_layout layout, bool full_range, int32_t width, int32_t height, pixel_buffer_pool_sptr pool = nullptr);
+
+        // Returns nullptr at the end of the file
+        pixel_buffer_sptr read_frame();
+
+        [[nodiscard]] bnb::oep::interfaces::image_format get_image_format() const
+        {
+            return m_format;
+        }
+
+        [[nodiscard]] int32_t get_width() const
+        {
+            return m_width;
+        }
+
+        [[nodiscard]] int32_t get_height() const
+        {
+            return m_height;
+        }
+
+        [[nodiscard]] int32_t get_fps_numerator() const
+        {
+            return m_fps_numerator;
+        }
+
+        [[nodiscard]] int32_t get_fps_denominator() const
+        {
+            return m_fps_denominator;
+        }
+
+        [[nodiscard]] const pixel_buffer_pool_sptr& get_pool() const
+        {
+            return m_pool;
+        }
+
+    private:
+        void read_y4m_header();
+
+        pixel_buffer_sptr read_packed_frame();
+
+    private:
+        std::ifstream m_file;
+        pixel_buffer_pool_sptr m_pool;
+        bool m_is_y4m {false};
+        std::optional<packed_yuv_layout> m_packed_layout;
+        std::vector<uint8_t> m_packed_frame;
+        bnb::oep::interfaces::image_format m_format {bnb::oep::interfaces::image_format::i420_bt601_video};
+        int32_t m_width {0};
+        int32_t m_height {0};
+        int32_t m_fps_numerator {30};
+        int32_t m_fps_denominator {1};
+    }; /* class frame_file_reader */
+
+    // Writes I420 frames into a Y4M file
+    class y4m_file_writer
+    {
+    public:
+        y4m_file_writer(const std::string& path, int32_t width, int32_t height, int32_t fps_numerator, int32_t fps_denominator, bool full_range);
+
+        // The image must be in one of the I420 formats and have the size passed to the constructor
+        void write_frame(const pixel_buffer_sptr& image);
+
+    private:
+        std::ofstream m_file;
+        int32_t m_width {0};
+        int32_t m_height {0};
+    }; /* class y4m_file_writer */
+
+} /* namespace bnb */
@@ -0,0 +1,186 @@
+#include "frame_throttler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace bnb
+{
+
+    /* frame_throttler::create */
+    frame_throttler_sptr frame_throttler::create(int32_t max_frames_in_flight, frame_drop_policy policy, submit_cb submit)
+    {
+        return std::make_shared<frame_throttler>(max_frames_in_flight, policy, std::move(submit));
+    }
+
+    /* frame_throttler::frame_throttler */
+    frame_throttler::frame_throttler(int32_t max_frames_in_flight, frame_drop_policy policy, submit_cb submit)
+        : m_submit(std::move(submit))
+        , m_max_frames_in_flight(std::max(1, max_frames_in_flight))
+        , m_policy(policy)
+    {
+        if (!m_submit) {
+            throw std::invalid_argument("frame_throttler needs a submit callback");
+        }
+    }
+
+    /* frame_throttler::push */
+    bool frame_throttler::push(pixel_buffer_sptr image)
+    {
+        if (image == nullptr) {
+            return false;
+        }
+
+        uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            ++m_statistics.frames_pushed;
+
+            if (m_statistics.frames_in_flight >= m_max_frames_in_flight) {
+                switch (m_policy) {
+                    case frame_drop_policy::drop_newest:
+                        ++m_statistics.frames_dropped;
+                        return false;
+                    case frame_drop_policy::drop_oldest:
+                        if (m_waiting_frame != nullptr) {
+                            ++m_statistics.frames_dropped;
+                        }
+                        m_waiting_frame = std::move(image);
+                        m_statistics.has_waiting_frame = true;
+                        return true;
+                    case frame_drop_policy::block: {
+                        // A reset means the frames in flight will never be returned, the frame that
+                        // waited for them is stale then as well
+                        auto waiting_generation = m_generation;
+                        auto is_slot_freed = [this, waiting_generation]() {
+                            return m_generation != waiting_generation || m_statistics.frames_in_flight < m_max_frames_in_flight;
+                        };
+                        // wait_for cannot take the maximum duration, it would overflow the deadline
+                        if (m_block_timeout == no_block_timeout) {
+                            m_slot_freed.wait(lock, is_slot_freed);
+                        } else {
+                            m_slot_freed.wait_for(lock, m_block_timeout, is_slot_freed);
+                        }
+                        if (m_generation != waiting_generation || m_statistics.frames_in_flight >= m_max_frames_in_flight) {
+                            ++m_statistics.frames_dropped;
+                            return false;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            ++m_statistics.frames_in_flight;
+            ++m_statistics.frames_submitted;
+            m_statistics.max_frames_in_flight_seen = std::max(m_statistics.max_frames_in_flight_seen, m_statistics.frames_in_flight);
+            generation = m_generation;
+        }
+        submit(std::move(image), generation);
+        return true;
+    }
+
+    /* frame_throttler::reset */
+    void frame_throttler::reset()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_generation;
+            m_statistics.frames_in_flight = 0;
+            m_waiting_frame.reset();
+            m_statistics.has_waiting_frame = false;
+        }
+        m_slot_freed.notify_all();
+    }
+
+    /* frame_throttler::set_max_frames_in_flight */
+    void frame_throttler::set_max_frames_in_flight(int32_t max_frames_in_flight)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_max_frames_in_flight = std::max(1, max_frames_in_flight);
+        }
+        m_slot_freed.notify_all();
+    }
+
+    /* frame_throttler::set_policy */
+    void frame_throttler::set_policy(frame_drop_policy policy)
+    {
+        pixel_buffer_sptr waiting_frame;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_policy = policy;
+            if (policy != frame_drop_policy::drop_oldest && m_waiting_frame != nullptr) {
+                waiting_frame = std::move(m_waiting_frame);
+                m_statistics.has_waiting_frame = false;
+                ++m_statistics.frames_dropped;
+            }
+        }
+        m_slot_freed.notify_all();
+    }
+
+    /* frame_throttler::set_block_timeout */
+    void frame_throttler::set_block_timeout(std::chrono::milliseconds timeout)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_block_timeout = timeout;
+    }
+
+    /* frame_throttler::get_statistics */
+    frame_throttler::statistics frame_throttler::get_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+    /* frame_throttler::on_frame_done */
+    void frame_throttler::on_frame_done(uint64_t generation)
+    {
+        pixel_buffer_sptr waiting_frame;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (generation != m_generation) {
+                return;
+            }
+            --m_statistics.frames_in_flight;
+
+            // The freed slot goes to the waiting frame right away, it is the freshest one
+            if (m_waiting_frame != nullptr && m_statistics.frames_in_flight < m_max_frames_in_flight) {
+                waiting_frame = std::move(m_waiting_frame);
+                m_statistics.has_waiting_frame = false;
+                ++m_statistics.frames_in_flight;
+                ++m_statistics.frames_submitted;
+            }
+        }
+
+        if (waiting_frame != nullptr) {
+            submit(std::move(waiting_frame), generation);
+        } else {
+            m_slot_freed.notify_one();
+        }
+    }
+
+    /* frame_throttler::submit */
+    void frame_throttler::submit(pixel_buffer_sptr image, uint64_t generation)
+    {
+        // The done callback may be called after the throttler is destroyed
+        m_submit(std::move(image), [weak_self = weak_from_this(), generation]() {
+            if (auto self = weak_self.lock()) {
+                self->on_frame_done(generation);
+            }
+        });
+    }
+
+    /* to_string */
+    const char* to_string(frame_drop_policy policy)
+    {
+        switch (policy) {
+            case frame_drop_policy::drop_newest:
+                return "drop newest";
+            case frame_drop_policy::drop_oldest:
+                return "drop oldest";
+            case frame_drop_policy::block:
+                return "block";
+        }
+        return "unknown";
+    }
+
+} /* namespace bnb */
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <interfaces/pixel_buffer.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace bnb
+{
+
+    // What happens to a frame that arrives while the in-flight window is full
+    enum class frame_drop_policy
+    {
+        drop_newest, /* the arriving frame is dropped */
+        drop_oldest, /* the arriving frame waits for a free slot and replaces the frame that waited before it */
+        block        /* the producer thread waits for a free slot, the frame is dropped only if none is freed in time */
+    };
+
+    class frame_throttler;
+    using frame_throttler_sptr = std::shared_ptr<frame_throttler>;
+
+    // Bounds the number of frames submitted to the OEP but not yet returned by it, so the
+    // OEP queue cannot grow when frames arrive faster than the effect is rendered
+    class frame_throttler : public std::enable_shared_from_this<frame_throttler>
+    {
+    public:
+        // Must be called exactly once when the OEP is done with the frame, from any thread
+        using frame_done_cb = std::function<void()>;
+        // Passes the frame to the OEP, called without internal locks held
+        using submit_cb = std::function<void(pixel_buffer_sptr image, frame_done_cb done)>;
+
+        struct statistics
+        {
+            uint64_t frames_pushed {0};
+            uint64_t frames_submitted {0};
+            uint64_t frames_dropped {0};
+            int32_t frames_in_flight {0};
+            int32_t max_frames_in_flight_seen {0};
+            bool has_waiting_frame {false};
+        };
+
+        // How long the block policy waits for a free slot by default
+        static constexpr std::chrono::milliseconds default_block_timeout {1000};
+        // Makes the block policy wait until a slot is freed or the throttler is reset
+        static constexpr std::chrono::milliseconds no_block_timeout {std::chrono::milliseconds::max()};
+
+        static frame_throttler_sptr create(int32_t max_frames_in_flight, frame_drop_policy policy, submit_cb submit);
+
+        // Use create(), done callbacks find the throttler through a weak pointer
+        frame_throttler(int32_t max_frames_in_flight, frame_drop_policy policy, submit_cb submit);
+
+        // Submits the frame, makes it wait or drops it according to the policy. The block policy
+        // also drops the frame when the throttler is reset while it waits. Returns false if the
+        // frame is dropped, a waiting frame later replaced by drop_oldest is not reported here.
+        bool push(pixel_buffer_sptr image);
+
+        // Forgets frames in flight and the waiting frame, e.g. after the OEP was stopped and
+        // will not return frames submitted before. Late done callbacks of those frames are ignored.
+        void reset();
+
+        void set_max_frames_in_flight(int32_t max_frames_in_flight);
+
+        void set_policy(frame_drop_policy policy);
+
+        // Bounds the wait of the block policy, so the producer thread is not stuck when the OEP
+        // stops returning frames (stopped, paused or a lost frame). A frame that waited longer is
+        // dropped, no_block_timeout waits for as long as it takes.
+        void set_block_timeout(std::chrono::milliseconds timeout);
+
+        statistics get_statistics() const;
+
+    private:
+        void on_frame_done(uint64_t generation);
+
+        void submit(pixel_buffer_sptr image, uint64_t generation);
+
+    private:
+        const submit_cb m_submit;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_slot_freed;
+        int32_t m_max_frames_in_flight;
+        frame_drop_policy m_policy;
+        std::chrono::milliseconds m_block_timeout {default_block_timeout};
+        pixel_buffer_sptr m_waiting_frame;
+        uint64_t m_generation {0};
+        statistics m_statistics;
+    }; /* class frame_throttler */
+
+    const char* to_string(frame_drop_policy policy);
+
+} /* namespace bnb */
@@ -3,8 +3,11 @@
 #include <bnb/effect_player/interfaces/effect_player.hpp>
 #include <bnb/spal/camera/base.hpp>
 
+#include "frame_throttler.hpp"
+
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace bnb
 {
@@ -14,12 +17,16 @@ namespace bnb
         glfw_user_data(
             offscreen_effect_player_sptr oep,
             renderer_sptr render_target,
+            frame_throttler_sptr throttler,
             bnb::camera_sptr& camera,
-            bnb::camera_base::push_frame_cb_t push_frame_cb)
+            bnb::camera_base::push_frame_cb_t push_frame_cb,
+            std::vector<std::string> effects = {})
             : m_oep(oep)
+            , m_throttler(throttler)
             , m_camera(camera)
             , m_render_target(render_target)
             , m_push_frame_cb(push_frame_cb)
+            , m_effects(std::move(effects))
         {
         }
 
@@ -37,6 +44,11 @@ namespace bnb
             return m_render_target.lock();
         }
 
+        frame_throttler_sptr throttler()
+        {
+            return m_throttler.lock();
+        }
+
         bnb::camera_sptr& camera_ptr()
         {
             return m_camera;
@@ -46,10 +58,18 @@ namespace bnb
         {
             return m_push_frame_cb;
         }
+
+        // Effects switched with the number keys
+        const std::vector<std::string>& effects() const
+        {
+            return m_effects;
+        }
     private:
         std::weak_ptr<offscreen_effect_player_sptr::element_type> m_oep;
+        std::weak_ptr<frame_throttler> m_throttler;
         bnb::camera_sptr& m_camera;
         std::weak_ptr<renderer_sptr::element_type> m_render_target;
         bnb::camera_base::push_frame_cb_t m_push_frame_cb;
+        std::vector<std::string> m_effects;
     };
 } // namespace viewer
@@ -0,0 +1,72 @@
+#include "js_command_queue.hpp"
+
+#include <algorithm>
+
+namespace bnb
+{
+
+    /* js_command_queue::push_method */
+    void js_command_queue::push_method(const std::string& method, const std::string& param)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_statistics.calls;
+        if (auto it = m_method_index.find(method); it != m_method_index.end()) {
+            m_commands[it->second].param = param;
+            ++m_statistics.coalesced_calls;
+            return;
+        }
+        m_method_index.emplace(method, m_commands.size());
+        m_commands.push_back({method, param, {}, nullptr});
+    }
+
+    /* js_command_queue::push_script */
+    void js_command_queue::push_script(const std::string& script, result_cb callback)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_statistics.calls;
+        // The script sees the effect as left by the calls before it, later calls are not moved over it
+        m_method_index.clear();
+        m_commands.push_back({{}, {}, script, std::move(callback)});
+    }
+
+    /* js_command_queue::take */
+    std::vector<js_command_queue::evaluation> js_command_queue::take()
+    {
+        std::vector<evaluation> commands;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        commands.swap(m_commands);
+        m_method_index.clear();
+        m_statistics.last_queue_depth = commands.size();
+        m_statistics.max_queue_depth = std::max(m_statistics.max_queue_depth, commands.size());
+        return commands;
+    }
+
+    /* js_command_queue::on_evaluated */
+    void js_command_queue::on_evaluated(size_t evaluations, std::chrono::steady_clock::duration js_time)
+    {
+        auto js_ms = std::chrono::duration<double, std::milli>(js_time).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.evaluations += evaluations;
+        ++m_frames_with_js;
+        m_total_js_ms += js_ms;
+        m_statistics.last_js_ms = js_ms;
+        m_statistics.average_js_ms = m_total_js_ms / static_cast<double>(m_frames_with_js);
+        m_statistics.max_js_ms = std::max(m_statistics.max_js_ms, js_ms);
+    }
+
+    /* js_command_queue::empty */
+    bool js_command_queue::empty() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_commands.empty();
+    }
+
+    /* js_command_queue::get_statistics */
+    js_command_queue::statistics js_command_queue::get_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_statistics;
+    }
+
+} /* namespace bnb */
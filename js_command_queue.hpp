@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bnb
+{
+
+    // Collects JS calls into the effect between frames, so the effect player makes them once per
+    // drawn frame instead of at any time. Repeated calls of the same method are coalesced, only the
+    // last parameter is passed, at the position of the first call after the latest script. Every
+    // remaining command is made on its own, in order: a method with call_js_method and a script
+    // with eval_js, so a throwing command or a script declaring the same names as another one
+    // does not affect the rest.
+    class js_command_queue
+    {
+    public:
+        using result_cb = std::function<void(const std::string& result)>;
+
+        // One call into the effect made by the effect player
+        struct evaluation
+        {
+            // Empty for scripts
+            std::string method;
+            std::string param;
+            std::string script;
+            result_cb callback;
+        };
+
+        struct statistics
+        {
+            uint64_t calls {0};
+            uint64_t coalesced_calls {0};
+            uint64_t evaluations {0};
+            // Commands taken by the last flush and the most taken at once
+            size_t last_queue_depth {0};
+            size_t max_queue_depth {0};
+            // Time the effect player spent in JS on the last frame with commands
+            double last_js_ms {0.0};
+            double average_js_ms {0.0};
+            double max_js_ms {0.0};
+        };
+
+        void push_method(const std::string& method, const std::string& param);
+
+        void push_script(const std::string& script, result_cb callback);
+
+        // Takes the queued commands, the queue is empty afterwards
+        std::vector<evaluation> take();
+
+        // Accounts the time the evaluations returned by take() took
+        void on_evaluated(size_t evaluations, std::chrono::steady_clock::duration js_time);
+
+        [[nodiscard]] bool empty() const;
+
+        statistics get_statistics() const;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<evaluation> m_commands;
+        // Position of the queued call of every method
+        std::unordered_map<std::string, size_t> m_method_index;
+        uint64_t m_frames_with_js {0};
+        double m_total_js_ms {0.0};
+        statistics m_statistics;
+    }; /* class js_command_queue */
+
+} /* namespace bnb */
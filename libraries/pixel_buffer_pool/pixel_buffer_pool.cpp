@@ -0,0 +1,278 @@
+#include "pixel_buffer_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+
+namespace
+{
+
+    using image_format = bnb::oep::interfaces::image_format;
+
+    int32_t align(int32_t value, int32_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+} /* namespace */
+
+namespace bnb
+{
+
+    /* get_planes_count */
+    int32_t get_planes_count(bnb::oep::interfaces::image_format format)
+    {
+        switch (format) {
+            case image_format::bpc8_rgb:
+            case image_format::bpc8_bgr:
+            case image_format::bpc8_rgba:
+            case image_format::bpc8_bgra:
+            case image_format::bpc8_argb:
+                return 1;
+            case image_format::nv12_bt601_full:
+            case image_format::nv12_bt601_video:
+            case image_format::nv12_bt709_full:
+            case image_format::nv12_bt709_video:
+                return 2;
+            case image_format::i420_bt601_full:
+            case image_format::i420_bt601_video:
+            case image_format::i420_bt709_full:
+            case image_format::i420_bt709_video:
+                return 3;
+        }
+        return 0;
+    }
+
+    /* get_plane_geometry */
+    plane_geometry get_plane_geometry(bnb::oep::interfaces::image_format format, int32_t plane, int32_t width, int32_t height)
+    {
+        auto chroma_width = (width + 1) / 2;
+        auto chroma_height = (height + 1) / 2;
+
+        switch (format) {
+            case image_format::bpc8_rgb:
+            case image_format::bpc8_bgr:
+                return {width * 3, height};
+            case image_format::bpc8_rgba:
+            case image_format::bpc8_bgra:
+            case image_format::bpc8_argb:
+                return {width * 4, height};
+            case image_format::nv12_bt601_full:
+            case image_format::nv12_bt601_video:
+            case image_format::nv12_bt709_full:
+            case image_format::nv12_bt709_video:
+                return plane == 0 ? plane_geometry {width, height} : plane_geometry {chroma_width * 2, chroma_height};
+            case image_format::i420_bt601_full:
+            case image_format::i420_bt601_video:
+            case image_format::i420_bt709_full:
+            case image_format::i420_bt709_video:
+                return plane == 0 ? plane_geometry {width, height} : plane_geometry {chroma_width, chroma_height};
+        }
+        return {};
+    }
+
+    struct pixel_buffer_pool::entry
+    {
+        // Enough for the shared_ptr control block with a stateless deleter and entry_allocator
+        static constexpr size_t control_block_capacity = 128;
+
+        entry_key key;
+        std::shared_ptr<uint8_t> data;
+        pixel_buffer_sptr buffer;
+        long own_data_references {0}; /* references to data held by the entry and by the planes of buffer */
+        alignas(std::max_align_t) unsigned char control_block[control_block_capacity];
+    };
+
+    // Places the control block of a handed out shared_ptr into its entry and returns
+    // the entry to the pool when the control block is released
+    template<typename T>
+    class pixel_buffer_pool::entry_allocator
+    {
+    public:
+        using value_type = T;
+
+        entry_allocator(entry* e, pixel_buffer_pool_sptr pool)
+            : m_entry(e)
+            , m_pool(std::move(pool))
+        {
+        }
+
+        template<typename U>
+        entry_allocator(const entry_allocator<U>& other)
+            : m_entry(other.m_entry)
+            , m_pool(other.m_pool)
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            static_assert(sizeof(T) <= entry::control_block_capacity, "control block does not fit into the pool entry");
+            static_assert(alignof(T) <= alignof(std::max_align_t), "control block is overaligned");
+            assert(n == 1);
+            return reinterpret_cast<T*>(m_entry->control_block);
+        }
+
+        void deallocate(T*, size_t)
+        {
+            // Called after the control block is destroyed, so the entry may be reused right away
+            m_pool->release(m_entry);
+        }
+
+        template<typename U>
+        bool operator==(const entry_allocator<U>& other) const
+        {
+            return m_entry == other.m_entry;
+        }
+
+        template<typename U>
+        bool operator!=(const entry_allocator<U>& other) const
+        {
+            return m_entry != other.m_entry;
+        }
+
+    private:
+        template<typename U>
+        friend class entry_allocator;
+
+        entry* m_entry;
+        pixel_buffer_pool_sptr m_pool;
+    }; /* class pixel_buffer_pool::entry_allocator */
+
+    /* pixel_buffer_pool::entry_key_hash::operator() */
+    size_t pixel_buffer_pool::entry_key_hash::operator()(const entry_key& key) const
+    {
+        auto hash = std::hash<int32_t>()(static_cast<int32_t>(key.format));
+        hash = hash * 31 + std::hash<int32_t>()(key.width);
+        hash = hash * 31 + std::hash<int32_t>()(key.height);
+        return hash;
+    }
+
+    /* pixel_buffer_pool::create */
+    pixel_buffer_pool_sptr pixel_buffer_pool::create(int32_t row_alignment)
+    {
+        return pixel_buffer_pool_sptr(new pixel_buffer_pool(std::max(1, row_alignment)));
+    }
+
+    /* pixel_buffer_pool::pixel_buffer_pool */
+    pixel_buffer_pool::pixel_buffer_pool(int32_t row_alignment)
+        : m_row_alignment(row_alignment)
+    {
+    }
+
+    /* pixel_buffer_pool::acquire */
+    pixel_buffer_sptr pixel_buffer_pool::acquire(bnb::oep::interfaces::image_format format, int32_t width, int32_t height)
+    {
+        entry_key key {format, width, height};
+        entry* e = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& free_entries = m_free_entries[key];
+            auto it = std::find_if(free_entries.rbegin(), free_entries.rend(), [this](entry* free_entry) {
+                return !is_referenced_outside(*free_entry);
+            });
+            if (it != free_entries.rend()) {
+                e = *it;
+                free_entries.erase(std::next(it).base());
+                ++m_hits;
+                m_high_water_mark = std::max(m_high_water_mark, ++m_buffers_in_use);
+            }
+        }
+
+        if (e == nullptr) {
+            auto new_entry = make_entry(key);
+            if (new_entry == nullptr) {
+                return nullptr;
+            }
+            e = new_entry.get();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.push_back(std::move(new_entry));
+            ++m_misses;
+            m_high_water_mark = std::max(m_high_water_mark, ++m_buffers_in_use);
+        }
+
+        return pixel_buffer_sptr(
+            e->buffer.get(),
+            [](bnb::oep::interfaces::pixel_buffer*) { /* the buffer is owned by the entry */ },
+            entry_allocator<bnb::oep::interfaces::pixel_buffer>(e, shared_from_this()));
+    }
+
+    /* pixel_buffer_pool::get_statistics */
+    pixel_buffer_pool::statistics pixel_buffer_pool::get_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return {m_hits, m_misses, m_entries.size(), m_buffers_in_use, m_high_water_mark};
+    }
+
+    /* pixel_buffer_pool::trim */
+    void pixel_buffer_pool::trim()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<entry*> unused;
+        for (auto& [key, free_entries] : m_free_entries) {
+            auto it = std::partition(free_entries.begin(), free_entries.end(), [this](entry* e) { return is_referenced_outside(*e); });
+            unused.insert(unused.end(), it, free_entries.end());
+            free_entries.erase(it, free_entries.end());
+        }
+        m_entries.erase(
+            std::remove_if(m_entries.begin(), m_entries.end(), [&unused](const std::unique_ptr<entry>& e) {
+                return std::find(unused.begin(), unused.end(), e.get()) != unused.end();
+            }),
+            m_entries.end());
+    }
+
+    /* pixel_buffer_pool::make_entry */
+    std::unique_ptr<pixel_buffer_pool::entry> pixel_buffer_pool::make_entry(const entry_key& key) const
+    {
+        auto planes_count = get_planes_count(key.format);
+        if (planes_count == 0 || key.width <= 0 || key.height <= 0) {
+            return nullptr;
+        }
+
+        size_t total_size = 0;
+        for (int32_t plane = 0; plane < planes_count; ++plane) {
+            auto geometry = get_plane_geometry(key.format, plane, key.width, key.height);
+            total_size += static_cast<size_t>(align(geometry.row_size, m_row_alignment)) * geometry.rows;
+        }
+
+        auto e = std::make_unique<entry>();
+        e->key = key;
+        e->data = std::shared_ptr<uint8_t>(new uint8_t[total_size], std::default_delete<uint8_t[]>());
+
+        std::vector<bnb::oep::interfaces::pixel_buffer::plane_data> planes;
+        size_t offset = 0;
+        for (int32_t plane = 0; plane < planes_count; ++plane) {
+            auto geometry = get_plane_geometry(key.format, plane, key.width, key.height);
+            auto bytes_per_row = align(geometry.row_size, m_row_alignment);
+            auto size = static_cast<size_t>(bytes_per_row) * geometry.rows;
+            planes.push_back({std::shared_ptr<uint8_t>(e->data, e->data.get() + offset), size, bytes_per_row});
+            offset += size;
+        }
+        e->buffer = bnb::oep::interfaces::pixel_buffer::create(planes, key.format, key.width, key.height);
+        planes.clear();
+        e->own_data_references = e->data.use_count();
+        return e;
+    }
+
+    /* pixel_buffer_pool::is_referenced_outside */
+    bool pixel_buffer_pool::is_referenced_outside(const entry& e) const
+    {
+        // Plane pointers obtained from a buffer may outlive it, e.g. in frames queued inside the SDK.
+        // The fence pairs with the release decrement of the last outside reference, so the pixel
+        // data is not overwritten while the previous user may still be reading it.
+        auto references = e.data.use_count();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return references > e.own_data_references;
+    }
+
+    /* pixel_buffer_pool::release */
+    void pixel_buffer_pool::release(entry* e)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free_entries[e->key].push_back(e);
+        --m_buffers_in_use;
+    }
+
+} /* namespace bnb */
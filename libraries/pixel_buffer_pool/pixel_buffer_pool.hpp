@@ -0,0 +1,95 @@
+#pragma once
+
+#include <interfaces/pixel_buffer.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace bnb
+{
+
+    // Size in bytes of a tightly packed row of the plane and the number of its rows,
+    // chroma planes of NV12 and I420 are subsampled by two in both directions
+    struct plane_geometry
+    {
+        int32_t row_size {0};
+        int32_t rows {0};
+    };
+
+    int32_t get_planes_count(bnb::oep::interfaces::image_format format);
+
+    plane_geometry get_plane_geometry(bnb::oep::interfaces::image_format format, int32_t plane, int32_t width, int32_t height);
+
+    class pixel_buffer_pool;
+
+    using pixel_buffer_pool_sptr = std::shared_ptr<pixel_buffer_pool>;
+
+    // Recycles pixel buffers keyed by format and size. A buffer returned by acquire() goes back
+    // to the pool when its last reference is released. Once the pool is warm, acquiring a buffer
+    // allocates nothing: the pixel data, the pixel_buffer object and even the reference counter
+    // of the returned shared pointer live in the pooled entry.
+    class pixel_buffer_pool : public std::enable_shared_from_this<pixel_buffer_pool>
+    {
+    public:
+        struct statistics
+        {
+            uint64_t hits {0};
+            uint64_t misses {0};
+            size_t buffers_allocated {0};
+            size_t buffers_in_use {0};
+            size_t high_water_mark {0}; /* the largest number of buffers in use at once */
+        };
+
+        // Rows of every plane start at a multiple of row_alignment bytes
+        static pixel_buffer_pool_sptr create(int32_t row_alignment = 1);
+
+        pixel_buffer_sptr acquire(bnb::oep::interfaces::image_format format, int32_t width, int32_t height);
+
+        [[nodiscard]] statistics get_statistics() const;
+
+        // Frees the buffers that are not in use
+        void trim();
+
+    private:
+        struct entry;
+        struct entry_key
+        {
+            bnb::oep::interfaces::image_format format;
+            int32_t width;
+            int32_t height;
+
+            bool operator==(const entry_key& other) const
+            {
+                return format == other.format && width == other.width && height == other.height;
+            }
+        };
+        struct entry_key_hash
+        {
+            size_t operator()(const entry_key& key) const;
+        };
+        template<typename T>
+        class entry_allocator;
+
+        explicit pixel_buffer_pool(int32_t row_alignment);
+
+        std::unique_ptr<entry> make_entry(const entry_key& key) const;
+        bool is_referenced_outside(const entry& e) const;
+        void release(entry* e);
+
+    private:
+        int32_t m_row_alignment;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::unique_ptr<entry>> m_entries;
+        std::unordered_map<entry_key, std::vector<entry*>, entry_key_hash> m_free_entries;
+
+        std::atomic_uint64_t m_hits {0};
+        std::atomic_uint64_t m_misses {0};
+        size_t m_buffers_in_use {0};
+        size_t m_high_water_mark {0};
+    }; /* class pixel_buffer_pool */
+
+} /* namespace bnb */
@@ -0,0 +1,180 @@
+#include "pixel_conversion.hpp"
+#include "pixel_conversion_rows.hpp"
+
+#if BNB_CONVERSION_X86 && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace
+{
+
+    using namespace bnb::conversion;
+
+    template<int y_offset, int uv_offset>
+    void packed_yuv_to_nv12(
+        const uint8_t* src, int32_t src_stride,
+        uint8_t* dst_y, int32_t dst_y_stride,
+        uint8_t* dst_uv, int32_t dst_uv_stride,
+        int32_t width, int32_t height)
+    {
+        for (int32_t r = 0; r < height; r += 2) {
+            // The last row of an odd height image is paired with itself
+            auto next = r + 1 < height ? r + 1 : r;
+            rows::packed_yuv_to_nv12<y_offset, uv_offset>(
+                src + static_cast<intptr_t>(r) * src_stride,
+                src + static_cast<intptr_t>(next) * src_stride,
+                dst_y + static_cast<intptr_t>(r) * dst_y_stride,
+                dst_y + static_cast<intptr_t>(next) * dst_y_stride,
+                dst_uv + static_cast<intptr_t>(r / 2) * dst_uv_stride,
+                0,
+                width);
+        }
+    }
+
+    void i420_to_nv12(
+        const uint8_t* src_u, int32_t src_u_stride,
+        const uint8_t* src_v, int32_t src_v_stride,
+        uint8_t* dst_uv, int32_t dst_uv_stride,
+        int32_t width, int32_t height)
+    {
+        auto chroma_width = (width + 1) / 2;
+        auto chroma_height = (height + 1) / 2;
+        for (int32_t r = 0; r < chroma_height; ++r) {
+            rows::interleave(
+                src_u + static_cast<intptr_t>(r) * src_u_stride,
+                src_v + static_cast<intptr_t>(r) * src_v_stride,
+                dst_uv + static_cast<intptr_t>(r) * dst_uv_stride,
+                0,
+                chroma_width);
+        }
+    }
+
+    void nv12_to_i420(
+        const uint8_t* src_uv, int32_t src_uv_stride,
+        uint8_t* dst_u, int32_t dst_u_stride,
+        uint8_t* dst_v, int32_t dst_v_stride,
+        int32_t width, int32_t height)
+    {
+        auto chroma_width = (width + 1) / 2;
+        auto chroma_height = (height + 1) / 2;
+        for (int32_t r = 0; r < chroma_height; ++r) {
+            rows::deinterleave(
+                src_uv + static_cast<intptr_t>(r) * src_uv_stride,
+                dst_u + static_cast<intptr_t>(r) * dst_u_stride,
+                dst_v + static_cast<intptr_t>(r) * dst_v_stride,
+                0,
+                chroma_width);
+        }
+    }
+
+    template<void (*row)(const uint8_t*, uint8_t*, int32_t, int32_t)>
+    void swizzle(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        for (int32_t r = 0; r < height; ++r) {
+            row(src + static_cast<intptr_t>(r) * src_stride, dst + static_cast<intptr_t>(r) * dst_stride, 0, width);
+        }
+    }
+
+    instruction_set detect_instruction_set()
+    {
+#if BNB_CONVERSION_X86
+    #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        auto max_leaf = info[0];
+        __cpuid(info, 1);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        bool avx2 = false;
+        // AVX2 also needs the OS to save YMM registers on context switches
+        if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    #else
+        __builtin_cpu_init();
+        bool sse41 = __builtin_cpu_supports("sse4.1");
+        bool avx2 = __builtin_cpu_supports("avx2");
+    #endif
+        if (avx2) {
+            return instruction_set::avx2;
+        }
+        if (sse41) {
+            return instruction_set::sse41;
+        }
+#endif
+        return instruction_set::scalar;
+    }
+
+} /* namespace */
+
+namespace bnb::conversion
+{
+
+    /* get_scalar_kernels */
+    const kernels& get_scalar_kernels()
+    {
+        static const kernels scalar_kernels {
+            packed_yuv_to_nv12<0, 1>,
+            packed_yuv_to_nv12<1, 0>,
+            i420_to_nv12,
+            nv12_to_i420,
+            swizzle<rows::rgba_to_bgra>,
+            swizzle<rows::argb_to_bgra>,
+            swizzle<rows::rgb_to_bgra>,
+            swizzle<rows::rgb_to_rgba>,
+            swizzle<rows::bgra_to_rgb>,
+        };
+        return scalar_kernels;
+    }
+
+    /* get_supported_instruction_set */
+    instruction_set get_supported_instruction_set()
+    {
+        static const instruction_set supported = detect_instruction_set();
+        return supported;
+    }
+
+    /* get_kernels */
+    const kernels& get_kernels(instruction_set isa)
+    {
+        auto supported = get_supported_instruction_set();
+        if (static_cast<int>(isa) > static_cast<int>(supported)) {
+            isa = supported;
+        }
+
+        switch (isa) {
+#if BNB_CONVERSION_X86
+            case instruction_set::avx2:
+                return get_avx2_kernels();
+            case instruction_set::sse41:
+                return get_sse41_kernels();
+#endif
+            default:
+                return get_scalar_kernels();
+        }
+    }
+
+    /* get_kernels */
+    const kernels& get_kernels()
+    {
+        static const kernels& best = get_kernels(get_supported_instruction_set());
+        return best;
+    }
+
+    /* to_string */
+    const char* to_string(instruction_set isa)
+    {
+        switch (isa) {
+            case instruction_set::scalar:
+                return "scalar";
+            case instruction_set::sse41:
+                return "sse4.1";
+            case instruction_set::avx2:
+                return "avx2";
+        }
+        return "unknown";
+    }
+
+} /* namespace bnb::conversion */
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bnb::conversion
+{
+
+    enum class instruction_set
+    {
+        scalar,
+        sse41,
+        avx2
+    };
+
+    // Converts packed 4:2:2 YUY2 or UYVY rows into NV12. Chroma of every two source rows is averaged
+    // (rounding up) into one NV12 chroma row. For an odd width the source rows hold (width + 1) / 2 pixel
+    // pairs, the last column takes the first luma of the last pair and its chroma, the second luma is unused.
+    using packed_yuv_to_nv12_fn = void (*)(
+        const uint8_t* src, int32_t src_stride,
+        uint8_t* dst_y, int32_t dst_y_stride,
+        uint8_t* dst_uv, int32_t dst_uv_stride,
+        int32_t width, int32_t height);
+
+    // Interleaves I420 chroma planes into the NV12 chroma plane, width and height are of the luma plane
+    using i420_to_nv12_fn = void (*)(
+        const uint8_t* src_u, int32_t src_u_stride,
+        const uint8_t* src_v, int32_t src_v_stride,
+        uint8_t* dst_uv, int32_t dst_uv_stride,
+        int32_t width, int32_t height);
+
+    // Splits the NV12 chroma plane into I420 chroma planes, width and height are of the luma plane
+    using nv12_to_i420_fn = void (*)(
+        const uint8_t* src_uv, int32_t src_uv_stride,
+        uint8_t* dst_u, int32_t dst_u_stride,
+        uint8_t* dst_v, int32_t dst_v_stride,
+        int32_t width, int32_t height);
+
+    // Reorders channels of a single plane image, width and height are in pixels
+    using swizzle_fn = void (*)(
+        const uint8_t* src, int32_t src_stride,
+        uint8_t* dst, int32_t dst_stride,
+        int32_t width, int32_t height);
+
+    struct kernels
+    {
+        packed_yuv_to_nv12_fn yuy2_to_nv12;
+        packed_yuv_to_nv12_fn uyvy_to_nv12;
+        i420_to_nv12_fn i420_to_nv12;
+        nv12_to_i420_fn nv12_to_i420;
+        swizzle_fn rgba_to_bgra; /* swaps R and B, so it also converts BGRA to RGBA */
+        swizzle_fn argb_to_bgra; /* reverses byte order, so it also converts BGRA to ARGB */
+        swizzle_fn rgb_to_bgra;  /* alpha is set to 255 */
+        swizzle_fn rgb_to_rgba;  /* alpha is set to 255 */
+        swizzle_fn bgra_to_rgb;  /* alpha is dropped */
+    };
+
+    // The best instruction set of the running CPU, detected once
+    instruction_set get_supported_instruction_set();
+
+    // Kernels for the given instruction set, or for the best supported one below it. All variants
+    // produce bit-exact results, the scalar variant is the reference.
+    const kernels& get_kernels(instruction_set isa);
+
+    // Kernels for the best instruction set of the running CPU
+    const kernels& get_kernels();
+
+    const char* to_string(instruction_set isa);
+
+} /* namespace bnb::conversion */
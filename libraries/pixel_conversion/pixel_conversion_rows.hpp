@@ -0,0 +1,115 @@
+#pragma once
+
+#include "pixel_conversion.hpp"
+
+// Scalar row routines, used by the reference kernels and for the tails of vectorized rows
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define BNB_CONVERSION_X86 1
+#else
+    #define BNB_CONVERSION_X86 0
+#endif
+
+namespace bnb::conversion::rows
+{
+
+    inline uint8_t average(uint8_t a, uint8_t b)
+    {
+        return static_cast<uint8_t>((a + b + 1) >> 1);
+    }
+
+    // y_offset and uv_offset are the positions of the first luma and the first chroma byte in a pixel pair
+    template<int y_offset, int uv_offset>
+    inline void packed_yuv_to_nv12(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1, uint8_t* uv, int32_t from, int32_t width)
+    {
+        for (int32_t x = from; x + 1 < width; x += 2) {
+            auto p0 = src0 + x * 2;
+            auto p1 = src1 + x * 2;
+            y0[x] = p0[y_offset];
+            y0[x + 1] = p0[y_offset + 2];
+            y1[x] = p1[y_offset];
+            y1[x + 1] = p1[y_offset + 2];
+            uv[x] = average(p0[uv_offset], p1[uv_offset]);
+            uv[x + 1] = average(p0[uv_offset + 2], p1[uv_offset + 2]);
+        }
+        // The last column of an odd width takes the first luma of the last, half used pixel pair,
+        // and its chroma pair like any other column
+        if (width % 2 != 0 && from < width) {
+            auto x = width - 1;
+            auto p0 = src0 + x * 2;
+            auto p1 = src1 + x * 2;
+            y0[x] = p0[y_offset];
+            y1[x] = p1[y_offset];
+            uv[x] = average(p0[uv_offset], p1[uv_offset]);
+            uv[x + 1] = average(p0[uv_offset + 2], p1[uv_offset + 2]);
+        }
+    }
+
+    inline void interleave(const uint8_t* u, const uint8_t* v, uint8_t* uv, int32_t from, int32_t width)
+    {
+        for (int32_t x = from; x < width; ++x) {
+            uv[x * 2] = u[x];
+            uv[x * 2 + 1] = v[x];
+        }
+    }
+
+    inline void deinterleave(const uint8_t* uv, uint8_t* u, uint8_t* v, int32_t from, int32_t width)
+    {
+        for (int32_t x = from; x < width; ++x) {
+            u[x] = uv[x * 2];
+            v[x] = uv[x * 2 + 1];
+        }
+    }
+
+    // Each destination byte c of a pixel is taken from source byte map[c], or is 255 if map[c] < 0
+    template<int src_bpp, int dst_bpp, int c0, int c1, int c2, int c3>
+    inline void swizzle(const uint8_t* src, uint8_t* dst, int32_t from, int32_t width)
+    {
+        constexpr int map[4] = {c0, c1, c2, c3};
+        for (int32_t x = from; x < width; ++x) {
+            auto s = src + x * src_bpp;
+            auto d = dst + x * dst_bpp;
+            for (int c = 0; c < dst_bpp; ++c) {
+                d[c] = map[c] < 0 ? 255 : s[map[c]];
+            }
+        }
+    }
+
+    inline void rgba_to_bgra(const uint8_t* src, uint8_t* dst, int32_t from, int32_t width)
+    {
+        swizzle<4, 4, 2, 1, 0, 3>(src, dst, from, width);
+    }
+
+    inline void argb_to_bgra(const uint8_t* src, uint8_t* dst, int32_t from, int32_t width)
+    {
+        swizzle<4, 4, 3, 2, 1, 0>(src, dst, from, width);
+    }
+
+    inline void rgb_to_bgra(const uint8_t* src, uint8_t* dst, int32_t from, int32_t width)
+    {
+        swizzle<3, 4, 2, 1, 0, -1>(src, dst, from, width);
+    }
+
+    inline void rgb_to_rgba(const uint8_t* src, uint8_t* dst, int32_t from, int32_t width)
+    {
+        swizzle<3, 4, 0, 1, 2, -1>(src, dst, from, width);
+    }
+
+    inline void bgra_to_rgb(const uint8_t* src, uint8_t* dst, int32_t from, int32_t width)
+    {
+        swizzle<4, 3, 2, 1, 0, 0>(src, dst, from, width);
+    }
+
+} /* namespace bnb::conversion::rows */
+
+namespace bnb::conversion
+{
+
+    const kernels& get_scalar_kernels();
+
+#if BNB_CONVERSION_X86
+    const kernels& get_sse41_kernels();
+    const kernels& get_avx2_kernels();
+#endif
+
+} /* namespace bnb::conversion */
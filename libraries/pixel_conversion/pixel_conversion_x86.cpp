@@ -0,0 +1,464 @@
+#include "pixel_conversion.hpp"
+#include "pixel_conversion_rows.hpp"
+
+#if BNB_CONVERSION_X86
+
+#include <immintrin.h>
+
+#include <cstring>
+
+// MSVC emits any intrinsic regardless of the target, GCC and Clang need a per-function target.
+// Callers must check the CPU before calling anything from this file, see get_kernels().
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define BNB_TARGET_SSE41
+    #define BNB_TARGET_AVX2
+#else
+    #define BNB_TARGET_SSE41 __attribute__((target("sse4.1")))
+    #define BNB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+
+    using namespace bnb::conversion;
+
+    using row_fn = void (*)(const uint8_t*, uint8_t*, int32_t, int32_t);
+
+    /* masks for _mm_shuffle_epi8, -1 zeroes the byte */
+    #define BNB_RGBA_TO_BGRA_MASK 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+    #define BNB_ARGB_TO_BGRA_MASK 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+    #define BNB_RGB_TO_BGRA_MASK 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1
+    #define BNB_RGB_TO_RGBA_MASK 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+    #define BNB_BGRA_TO_RGB_MASK 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+
+    inline const uint8_t* row_ptr(const uint8_t* base, int32_t stride, int32_t row)
+    {
+        return base + static_cast<intptr_t>(row) * stride;
+    }
+
+    inline uint8_t* row_ptr(uint8_t* base, int32_t stride, int32_t row)
+    {
+        return base + static_cast<intptr_t>(row) * stride;
+    }
+
+    /*
+     * SSE4.1
+     */
+
+    template<int y_offset>
+    BNB_TARGET_SSE41 void packed_yuv_to_nv12_sse41(
+        const uint8_t* src, int32_t src_stride,
+        uint8_t* dst_y, int32_t dst_y_stride,
+        uint8_t* dst_uv, int32_t dst_uv_stride,
+        int32_t width, int32_t height)
+    {
+        const __m128i low_bytes = _mm_set1_epi16(0x00ff);
+
+        for (int32_t r = 0; r < height; r += 2) {
+            auto next = r + 1 < height ? r + 1 : r;
+            auto s0 = row_ptr(src, src_stride, r);
+            auto s1 = row_ptr(src, src_stride, next);
+            auto y0 = row_ptr(dst_y, dst_y_stride, r);
+            auto y1 = row_ptr(dst_y, dst_y_stride, next);
+            auto uv = row_ptr(dst_uv, dst_uv_stride, r / 2);
+
+            int32_t x = 0;
+            for (; x + 16 <= width; x += 16) {
+                auto a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s0 + x * 2));
+                auto a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s0 + x * 2 + 16));
+                auto b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s1 + x * 2));
+                auto b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s1 + x * 2 + 16));
+
+                __m128i ya, yb, ca, cb;
+                if constexpr (y_offset == 0) { /* YUY2: luma in even bytes */
+                    ya = _mm_packus_epi16(_mm_and_si128(a0, low_bytes), _mm_and_si128(a1, low_bytes));
+                    yb = _mm_packus_epi16(_mm_and_si128(b0, low_bytes), _mm_and_si128(b1, low_bytes));
+                    ca = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+                    cb = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+                } else { /* UYVY: luma in odd bytes */
+                    ya = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+                    yb = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+                    ca = _mm_packus_epi16(_mm_and_si128(a0, low_bytes), _mm_and_si128(a1, low_bytes));
+                    cb = _mm_packus_epi16(_mm_and_si128(b0, low_bytes), _mm_and_si128(b1, low_bytes));
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + x), ya);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + x), yb);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + x), _mm_avg_epu8(ca, cb));
+            }
+            rows::packed_yuv_to_nv12<y_offset, 1 - y_offset>(s0, s1, y0, y1, uv, x, width);
+        }
+    }
+
+    BNB_TARGET_SSE41 void i420_to_nv12_sse41(
+        const uint8_t* src_u, int32_t src_u_stride,
+        const uint8_t* src_v, int32_t src_v_stride,
+        uint8_t* dst_uv, int32_t dst_uv_stride,
+        int32_t width, int32_t height)
+    {
+        auto chroma_width = (width + 1) / 2;
+        auto chroma_height = (height + 1) / 2;
+
+        for (int32_t r = 0; r < chroma_height; ++r) {
+            auto u = row_ptr(src_u, src_u_stride, r);
+            auto v = row_ptr(src_v, src_v_stride, r);
+            auto uv = row_ptr(dst_uv, dst_uv_stride, r);
+
+            int32_t x = 0;
+            for (; x + 16 <= chroma_width; x += 16) {
+                auto u16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+                auto v16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + x * 2), _mm_unpacklo_epi8(u16, v16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + x * 2 + 16), _mm_unpackhi_epi8(u16, v16));
+            }
+            rows::interleave(u, v, uv, x, chroma_width);
+        }
+    }
+
+    BNB_TARGET_SSE41 void nv12_to_i420_sse41(
+        const uint8_t* src_uv, int32_t src_uv_stride,
+        uint8_t* dst_u, int32_t dst_u_stride,
+        uint8_t* dst_v, int32_t dst_v_stride,
+        int32_t width, int32_t height)
+    {
+        const __m128i low_bytes = _mm_set1_epi16(0x00ff);
+        auto chroma_width = (width + 1) / 2;
+        auto chroma_height = (height + 1) / 2;
+
+        for (int32_t r = 0; r < chroma_height; ++r) {
+            auto uv = row_ptr(src_uv, src_uv_stride, r);
+            auto u = row_ptr(dst_u, dst_u_stride, r);
+            auto v = row_ptr(dst_v, dst_v_stride, r);
+
+            int32_t x = 0;
+            for (; x + 16 <= chroma_width; x += 16) {
+                auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x * 2));
+                auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x * 2 + 16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(u + x), _mm_packus_epi16(_mm_and_si128(a, low_bytes), _mm_and_si128(b, low_bytes)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+            }
+            rows::deinterleave(uv, u, v, x, chroma_width);
+        }
+    }
+
+    // 4 bytes per pixel to 4 bytes per pixel, 4 pixels per step
+    template<row_fn tail>
+    BNB_TARGET_SSE41 void shuffle_32_to_32_sse41(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height, __m128i mask)
+    {
+        for (int32_t r = 0; r < height; ++r) {
+            auto s = row_ptr(src, src_stride, r);
+            auto d = row_ptr(dst, dst_stride, r);
+
+            int32_t x = 0;
+            for (; x + 4 <= width; x += 4) {
+                auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * 4));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + x * 4), _mm_shuffle_epi8(p, mask));
+            }
+            tail(s, d, x, width);
+        }
+    }
+
+    // 3 bytes per pixel to 4 bytes per pixel with opaque alpha, 4 pixels per step.
+    // A step loads 16 bytes, so it needs 6 pixels left in the row to stay inside of it.
+    template<row_fn tail>
+    BNB_TARGET_SSE41 void shuffle_24_to_32_sse41(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height, __m128i mask)
+    {
+        const __m128i alpha = _mm_set1_epi32(static_cast<int32_t>(0xff000000));
+
+        for (int32_t r = 0; r < height; ++r) {
+            auto s = row_ptr(src, src_stride, r);
+            auto d = row_ptr(dst, dst_stride, r);
+
+            int32_t x = 0;
+            for (; x + 6 <= width; x += 4) {
+                auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * 3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + x * 4), _mm_or_si128(_mm_shuffle_epi8(p, mask), alpha));
+            }
+            tail(s, d, x, width);
+        }
+    }
+
+    // 4 bytes per pixel to 3 bytes per pixel, 4 pixels per step
+    template<row_fn tail>
+    BNB_TARGET_SSE41 void shuffle_32_to_24_sse41(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height, __m128i mask)
+    {
+        for (int32_t r = 0; r < height; ++r) {
+            auto s = row_ptr(src, src_stride, r);
+            auto d = row_ptr(dst, dst_stride, r);
+
+            int32_t x = 0;
+            for (; x + 4 <= width; x += 4) {
+                auto p = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * 4)), mask);
+                auto last = _mm_extract_epi32(p, 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(d + x * 3), p);
+                std::memcpy(d + x * 3 + 8, &last, 4);
+            }
+            tail(s, d, x, width);
+        }
+    }
+
+    BNB_TARGET_SSE41 void rgba_to_bgra_sse41(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_32_to_32_sse41<rows::rgba_to_bgra>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_RGBA_TO_BGRA_MASK));
+    }
+
+    BNB_TARGET_SSE41 void argb_to_bgra_sse41(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_32_to_32_sse41<rows::argb_to_bgra>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_ARGB_TO_BGRA_MASK));
+    }
+
+    BNB_TARGET_SSE41 void rgb_to_bgra_sse41(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_24_to_32_sse41<rows::rgb_to_bgra>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_RGB_TO_BGRA_MASK));
+    }
+
+    BNB_TARGET_SSE41 void rgb_to_rgba_sse41(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_24_to_32_sse41<rows::rgb_to_rgba>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_RGB_TO_RGBA_MASK));
+    }
+
+    BNB_TARGET_SSE41 void bgra_to_rgb_sse41(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_32_to_24_sse41<rows::bgra_to_rgb>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_BGRA_TO_RGB_MASK));
+    }
+
+    /*
+     * AVX2
+     */
+
+    template<int y_offset>
+    BNB_TARGET_AVX2 void packed_yuv_to_nv12_avx2(
+        const uint8_t* src, int32_t src_stride,
+        uint8_t* dst_y, int32_t dst_y_stride,
+        uint8_t* dst_uv, int32_t dst_uv_stride,
+        int32_t width, int32_t height)
+    {
+        const __m256i low_bytes = _mm256_set1_epi16(0x00ff);
+
+        for (int32_t r = 0; r < height; r += 2) {
+            auto next = r + 1 < height ? r + 1 : r;
+            auto s0 = row_ptr(src, src_stride, r);
+            auto s1 = row_ptr(src, src_stride, next);
+            auto y0 = row_ptr(dst_y, dst_y_stride, r);
+            auto y1 = row_ptr(dst_y, dst_y_stride, next);
+            auto uv = row_ptr(dst_uv, dst_uv_stride, r / 2);
+
+            int32_t x = 0;
+            for (; x + 32 <= width; x += 32) {
+                auto a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s0 + x * 2));
+                auto a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s0 + x * 2 + 32));
+                auto b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s1 + x * 2));
+                auto b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s1 + x * 2 + 32));
+
+                __m256i ya, yb, ca, cb;
+                if constexpr (y_offset == 0) {
+                    ya = _mm256_packus_epi16(_mm256_and_si256(a0, low_bytes), _mm256_and_si256(a1, low_bytes));
+                    yb = _mm256_packus_epi16(_mm256_and_si256(b0, low_bytes), _mm256_and_si256(b1, low_bytes));
+                    ca = _mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8));
+                    cb = _mm256_packus_epi16(_mm256_srli_epi16(b0, 8), _mm256_srli_epi16(b1, 8));
+                } else {
+                    ya = _mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8));
+                    yb = _mm256_packus_epi16(_mm256_srli_epi16(b0, 8), _mm256_srli_epi16(b1, 8));
+                    ca = _mm256_packus_epi16(_mm256_and_si256(a0, low_bytes), _mm256_and_si256(a1, low_bytes));
+                    cb = _mm256_packus_epi16(_mm256_and_si256(b0, low_bytes), _mm256_and_si256(b1, low_bytes));
+                }
+
+                // packus works within 128-bit lanes, restore the order of 64-bit quarters
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(y0 + x), _mm256_permute4x64_epi64(ya, 0xd8));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(y1 + x), _mm256_permute4x64_epi64(yb, 0xd8));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + x), _mm256_permute4x64_epi64(_mm256_avg_epu8(ca, cb), 0xd8));
+            }
+            rows::packed_yuv_to_nv12<y_offset, 1 - y_offset>(s0, s1, y0, y1, uv, x, width);
+        }
+    }
+
+    BNB_TARGET_AVX2 void i420_to_nv12_avx2(
+        const uint8_t* src_u, int32_t src_u_stride,
+        const uint8_t* src_v, int32_t src_v_stride,
+        uint8_t* dst_uv, int32_t dst_uv_stride,
+        int32_t width, int32_t height)
+    {
+        auto chroma_width = (width + 1) / 2;
+        auto chroma_height = (height + 1) / 2;
+
+        for (int32_t r = 0; r < chroma_height; ++r) {
+            auto u = row_ptr(src_u, src_u_stride, r);
+            auto v = row_ptr(src_v, src_v_stride, r);
+            auto uv = row_ptr(dst_uv, dst_uv_stride, r);
+
+            int32_t x = 0;
+            for (; x + 32 <= chroma_width; x += 32) {
+                auto u32 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + x));
+                auto v32 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + x));
+                auto lo = _mm256_unpacklo_epi8(u32, v32);
+                auto hi = _mm256_unpackhi_epi8(u32, v32);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + x * 2), _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + x * 2 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+            }
+            rows::interleave(u, v, uv, x, chroma_width);
+        }
+    }
+
+    BNB_TARGET_AVX2 void nv12_to_i420_avx2(
+        const uint8_t* src_uv, int32_t src_uv_stride,
+        uint8_t* dst_u, int32_t dst_u_stride,
+        uint8_t* dst_v, int32_t dst_v_stride,
+        int32_t width, int32_t height)
+    {
+        const __m256i low_bytes = _mm256_set1_epi16(0x00ff);
+        auto chroma_width = (width + 1) / 2;
+        auto chroma_height = (height + 1) / 2;
+
+        for (int32_t r = 0; r < chroma_height; ++r) {
+            auto uv = row_ptr(src_uv, src_uv_stride, r);
+            auto u = row_ptr(dst_u, dst_u_stride, r);
+            auto v = row_ptr(dst_v, dst_v_stride, r);
+
+            int32_t x = 0;
+            for (; x + 32 <= chroma_width; x += 32) {
+                auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + x * 2));
+                auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + x * 2 + 32));
+                auto u32 = _mm256_packus_epi16(_mm256_and_si256(a, low_bytes), _mm256_and_si256(b, low_bytes));
+                auto v32 = _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(u + x), _mm256_permute4x64_epi64(u32, 0xd8));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + x), _mm256_permute4x64_epi64(v32, 0xd8));
+            }
+            rows::deinterleave(uv, u, v, x, chroma_width);
+        }
+    }
+
+    // 4 bytes per pixel to 4 bytes per pixel, 8 pixels per step
+    template<row_fn tail>
+    BNB_TARGET_AVX2 void shuffle_32_to_32_avx2(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height, __m128i lane_mask)
+    {
+        const __m256i mask = _mm256_broadcastsi128_si256(lane_mask);
+
+        for (int32_t r = 0; r < height; ++r) {
+            auto s = row_ptr(src, src_stride, r);
+            auto d = row_ptr(dst, dst_stride, r);
+
+            int32_t x = 0;
+            for (; x + 8 <= width; x += 8) {
+                auto p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + x * 4));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + x * 4), _mm256_shuffle_epi8(p, mask));
+            }
+            tail(s, d, x, width);
+        }
+    }
+
+    // 3 bytes per pixel to 4 bytes per pixel with opaque alpha, 8 pixels per step.
+    // Each lane loads 16 bytes, so a step needs 10 pixels left in the row to stay inside of it.
+    template<row_fn tail>
+    BNB_TARGET_AVX2 void shuffle_24_to_32_avx2(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height, __m128i lane_mask)
+    {
+        const __m256i mask = _mm256_broadcastsi128_si256(lane_mask);
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int32_t>(0xff000000));
+
+        for (int32_t r = 0; r < height; ++r) {
+            auto s = row_ptr(src, src_stride, r);
+            auto d = row_ptr(dst, dst_stride, r);
+
+            int32_t x = 0;
+            for (; x + 10 <= width; x += 8) {
+                auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * 3));
+                auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * 3 + 12));
+                auto p = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + x * 4), _mm256_or_si256(_mm256_shuffle_epi8(p, mask), alpha));
+            }
+            tail(s, d, x, width);
+        }
+    }
+
+    // 4 bytes per pixel to 3 bytes per pixel, 8 pixels per step
+    template<row_fn tail>
+    BNB_TARGET_AVX2 void shuffle_32_to_24_avx2(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height, __m128i lane_mask)
+    {
+        const __m256i mask = _mm256_broadcastsi128_si256(lane_mask);
+
+        for (int32_t r = 0; r < height; ++r) {
+            auto s = row_ptr(src, src_stride, r);
+            auto d = row_ptr(dst, dst_stride, r);
+
+            int32_t x = 0;
+            for (; x + 8 <= width; x += 8) {
+                auto p = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + x * 4)), mask);
+                auto lo = _mm256_castsi256_si128(p);
+                auto hi = _mm256_extracti128_si256(p, 1);
+                auto lo_last = _mm_extract_epi32(lo, 2);
+                auto hi_last = _mm_extract_epi32(hi, 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(d + x * 3), lo);
+                std::memcpy(d + x * 3 + 8, &lo_last, 4);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(d + x * 3 + 12), hi);
+                std::memcpy(d + x * 3 + 20, &hi_last, 4);
+            }
+            tail(s, d, x, width);
+        }
+    }
+
+    BNB_TARGET_AVX2 void rgba_to_bgra_avx2(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_32_to_32_avx2<rows::rgba_to_bgra>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_RGBA_TO_BGRA_MASK));
+    }
+
+    BNB_TARGET_AVX2 void argb_to_bgra_avx2(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_32_to_32_avx2<rows::argb_to_bgra>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_ARGB_TO_BGRA_MASK));
+    }
+
+    BNB_TARGET_AVX2 void rgb_to_bgra_avx2(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_24_to_32_avx2<rows::rgb_to_bgra>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_RGB_TO_BGRA_MASK));
+    }
+
+    BNB_TARGET_AVX2 void rgb_to_rgba_avx2(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_24_to_32_avx2<rows::rgb_to_rgba>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_RGB_TO_RGBA_MASK));
+    }
+
+    BNB_TARGET_AVX2 void bgra_to_rgb_avx2(const uint8_t* src, int32_t src_stride, uint8_t* dst, int32_t dst_stride, int32_t width, int32_t height)
+    {
+        shuffle_32_to_24_avx2<rows::bgra_to_rgb>(src, src_stride, dst, dst_stride, width, height, _mm_setr_epi8(BNB_BGRA_TO_RGB_MASK));
+    }
+
+} /* namespace */
+
+namespace bnb::conversion
+{
+
+    /* get_sse41_kernels */
+    const kernels& get_sse41_kernels()
+    {
+        static const kernels sse41_kernels {
+            packed_yuv_to_nv12_sse41<0>,
+            packed_yuv_to_nv12_sse41<1>,
+            i420_to_nv12_sse41,
+            nv12_to_i420_sse41,
+            rgba_to_bgra_sse41,
+            argb_to_bgra_sse41,
+            rgb_to_bgra_sse41,
+            rgb_to_rgba_sse41,
+            bgra_to_rgb_sse41,
+        };
+        return sse41_kernels;
+    }
+
+    /* get_avx2_kernels */
+    const kernels& get_avx2_kernels()
+    {
+        static const kernels avx2_kernels {
+            packed_yuv_to_nv12_avx2<0>,
+            packed_yuv_to_nv12_avx2<1>,
+            i420_to_nv12_avx2,
+            nv12_to_i420_avx2,
+            rgba_to_bgra_avx2,
+            argb_to_bgra_avx2,
+            rgb_to_bgra_avx2,
+            rgb_to_rgba_avx2,
+            bgra_to_rgb_avx2,
+        };
+        return avx2_kernels;
+    }
+
+} /* namespace bnb::conversion */
+
+#endif /* BNB_CONVERSION_X86 */
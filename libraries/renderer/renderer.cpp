@@ -1,7 +1,19 @@
 #include "renderer.hpp"
 
+#include "frame_trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
 using namespace bnb::render;
 
+#ifndef NDEBUG
+    // Debug builds count the GL calls of the present pass, see renderer::get_gl_calls_count
+    #define BNB_COUNT_GL_CALLS(count) (m_gl_calls_count += (count))
+#else
+    #define BNB_COUNT_GL_CALLS(count) ((void) 0)
+#endif
+
 /* renderer::~renderer */
 renderer::~renderer()
 {
@@ -11,42 +23,126 @@ renderer::~renderer()
 /* renderer::surface_changed */
 void renderer::surface_changed(int32_t width, int32_t height)
 {
-    m_width = width;
-    m_height = height;
-    m_surface_changed = true;
+    {
+        std::lock_guard<std::mutex> lock(m_wakeup_mutex);
+        m_width = width;
+        m_height = height;
+        m_surface_changed = true;
+    }
+    m_wakeup_cv.notify_one();
 }
 
 /* renderer::update_texture */
-void renderer::update_texture(GLuint texture)
+void renderer::update_texture(GLuint texture, int32_t width, int32_t height, uint64_t trace_frame, std::chrono::steady_clock::time_point timestamp)
+{
+    if (timestamp == std::chrono::steady_clock::time_point {}) {
+        timestamp = std::chrono::steady_clock::now();
+    }
+
+    // glFlush makes the fence visible to the render thread's context without waiting for the GPU
+    auto fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    if (auto dropped = m_frames.publish({texture, ++m_frame_sequence, fence, trace_frame, timestamp, width, height}); dropped && dropped->fence) {
+        glDeleteSync(dropped->fence);
+    }
+    // The handoff itself is lock-free, the empty critical section only orders the
+    // notification after the wait predicate check so the wakeup cannot be lost
+    { std::lock_guard<std::mutex> lock(m_wakeup_mutex); }
+    m_wakeup_cv.notify_one();
+}
+
+/* renderer::set_fit_mode */
+void renderer::set_fit_mode(fit_mode mode)
+{
+    m_fit_mode = mode;
+}
+
+/* renderer::set_present_mode */
+void renderer::set_present_mode(present_mode mode)
+{
+    m_present_mode = mode;
+    m_wakeup_cv.notify_one();
+}
+
+/* renderer::get_pacing_statistics */
+renderer::pacing_statistics renderer::get_pacing_statistics() const
+{
+    std::lock_guard<std::mutex> lock(m_pacing_mutex);
+    return m_pacing_statistics;
+}
+
+/* renderer::set_idle_timeout */
+void renderer::set_idle_timeout(std::chrono::milliseconds timeout)
 {
-    m_texture_id = texture;
-    m_texture_updated = true;
+    m_idle_timeout_ms = timeout.count();
+    m_wakeup_cv.notify_one();
 }
 
 /* renderer::start_auto_rendering */
 void renderer::start_auto_rendering(GLFWwindow* window)
 {
+    if (m_auto_rendering_is_running.exchange(true)) {
+        throw std::runtime_error("auto rendering already is runing");
+    }
+
     auto thread_func = [this, window]() {
-        using namespace std::chrono_literals;
-        if (m_auto_rendering_is_running) {
-            throw std::runtime_error("auto rendering already is runing");
-        }
-        m_auto_rendering_is_running = true;
         glfwMakeContextCurrent(window);
-        glfwSwapInterval(1);
+        auto applied_present_mode = m_present_mode.load();
+        apply_present_mode(applied_present_mode);
         initialize();
 
-        while (m_auto_rendering_is_running) {
-            if (m_surface_changed) {
-                glViewport(0, 0, m_width, m_height);
-                m_surface_changed = false;
+        while (true) {
+            bool surface_changed = false;
+            int32_t width = 0;
+            int32_t height = 0;
+
+            {
+                std::unique_lock<std::mutex> lock(m_wakeup_mutex);
+                m_wakeup_cv.wait_for(lock, std::chrono::milliseconds(m_idle_timeout_ms.load()), [this]() {
+                    return !m_auto_rendering_is_running || m_frames.has_new_frame() || m_surface_changed;
+                });
+                ++m_wakeups_count;
+                if (!m_auto_rendering_is_running) {
+                    break;
+                }
+                if (m_surface_changed) {
+                    width = m_width;
+                    height = m_height;
+                    surface_changed = true;
+                    m_surface_changed = false;
+                }
+            }
+
+            if (auto mode = m_present_mode.load(); mode != applied_present_mode) {
+                apply_present_mode(mode);
+                applied_present_mode = mode;
+            }
+            if (surface_changed) {
+                glViewport(0, 0, width, height);
+                m_viewport_width = width;
+                m_viewport_height = height;
+            }
+            if (!surface_changed && !m_frames.has_new_frame()) {
+                continue;
             }
-            if (m_texture_updated) {
-                draw_texture(m_texture_id);
-                m_texture_updated = false;
+
+            // After a surface change without a new frame the last one is presented again
+            bool is_new_frame = false;
+            auto& frame = m_frames.consume(is_new_frame);
+            if (frame.texture != 0) {
+                if (is_new_frame && applied_present_mode == present_mode::paced) {
+                    wait_paced_present(frame);
+                }
+                wait_frame_fence(frame);
+                draw_texture(frame);
+                BNB_COUNT_GL_CALLS(1);
                 glfwSwapBuffers(window);
-            } else {
-                std::this_thread::sleep_for(1us);
+                ++m_presented_frames_count;
+                if (is_new_frame) {
+                    bnb::trace::record(frame.trace_frame, bnb::trace::stage::presented);
+                    account_present(frame);
+                }
             }
         }
 
@@ -60,8 +156,15 @@ void renderer::start_auto_rendering(GLFWwindow* window)
 /* renderer::stop_auto_rendering */
 void renderer::stop_auto_rendering()
 {
-    if (m_auto_rendering_is_running) {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeup_mutex);
+        if (!m_auto_rendering_is_running) {
+            return;
+        }
         m_auto_rendering_is_running = false;
+    }
+    m_wakeup_cv.notify_one();
+    if (m_auto_rendering_thread.joinable()) {
         m_auto_rendering_thread.join();
     }
 }
@@ -74,9 +177,10 @@ void renderer::initialize()
         "precision highp float;\n "
         "layout (location = 0) in vec3 aPos;\n"
         "layout (location = 1) in vec2 aTexCoord;\n"
+        "uniform vec2 uScale;\n"
         "out vec2 vTexCoord;\n"
         "void main() {\n"
-        "  gl_Position = vec4(aPos, 1.0);\n"
+        "  gl_Position = vec4(aPos.xy * uScale, aPos.z, 1.0);\n"
         "  vTexCoord = aTexCoord;\n"
         "}\n";
 
@@ -99,6 +203,11 @@ void renderer::initialize()
     // clang-format on
 
     m_program = std::make_unique<bnb::oep::program>("", vertex_shader_program, fragment_shader_program);
+    // The program class does not expose its id, it is taken from the bound program
+    m_program->use();
+    GLint program_id = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program_id);
+    m_scale_location = glGetUniformLocation(program_id, "uScale");
 
     glGenVertexArrays(1, &m_vao);
     glGenBuffers(1, &m_vbo);
@@ -110,13 +219,47 @@ void renderer::initialize()
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(0);
     glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Filtering is a state of the sampler, the OEP texture is shared with the OEP context and
+    // changing its parameters would make the driver revalidate it in both contexts
+    glGenSamplers(1, &m_sampler);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // The context of the window is used by the render thread only, so the program, the vertex
+    // array and the sampler stay bound and the present pass binds just the frame texture
+    glActiveTexture(GL_TEXTURE0);
+    glBindSampler(0, m_sampler);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    m_fit_scale_uploaded = false;
 }
 
 /* renderer::shutdown */
 void renderer::shutdown()
 {
+    // Release the fence of a frame that was published but never presented
+    if (m_frames.has_new_frame()) {
+        bool is_new_frame = false;
+        auto& frame = m_frames.consume(is_new_frame);
+        if (frame.fence != nullptr) {
+            glDeleteSync(frame.fence);
+            frame.fence = nullptr;
+        }
+    }
+
+    glBindVertexArray(0);
+    glBindSampler(0, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (m_program != nullptr) {
+        m_program->unuse();
+    }
+    if (m_sampler != 0) {
+        glDeleteSamplers(1, &m_sampler);
+        m_sampler = 0;
+    }
     if (m_vao != 0) {
         glDeleteVertexArrays(1, &m_vao);
         m_vao = 0;
@@ -129,18 +272,174 @@ void renderer::shutdown()
 }
 
 /* renderer::draw_texture */
-void renderer::draw_texture(GLuint texture)
+void renderer::draw_texture(const texture_frame& frame)
 {
-    m_program->use();
+    // Bound every frame even if the name is the same: the OEP may delete a texture and get its name
+    // for a new one, while this context would keep the deleted texture bound
+    BNB_COUNT_GL_CALLS(1);
+    glBindTexture(GL_TEXTURE_2D, frame.texture);
 
-    glActiveTexture(GLenum(GL_TEXTURE0));
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // The quad is scaled only when the frame, the surface or the mode changes. Until the OEP
+    // has followed a resize of the window its frames keep the previous size and are fitted the same way.
+    // The size comes with the frame, the OEP may reallocate a texture keeping its name.
+    auto texture_width = frame.width;
+    auto texture_height = frame.height;
+    auto mode = m_fit_mode.load();
+    if (texture_width != m_fitted_texture_width || texture_height != m_fitted_texture_height || m_viewport_width != m_fitted_viewport_width
+        || m_viewport_height != m_fitted_viewport_height || mode != m_fitted_mode) {
+        m_fitted_texture_width = texture_width;
+        m_fitted_texture_height = texture_height;
+        m_fitted_viewport_width = m_viewport_width;
+        m_fitted_viewport_height = m_viewport_height;
+        m_fitted_mode = mode;
+        update_fit_scale();
+        m_fit_scale_uploaded = false;
+    }
+    if (!m_fit_scale_uploaded) {
+        BNB_COUNT_GL_CALLS(1);
+        glUniform2f(m_scale_location, m_fit_scale[0], m_fit_scale[1]);
+        m_fit_scale_uploaded = true;
+    }
+    if (m_fit_scale[0] < 1.0f || m_fit_scale[1] < 1.0f) {
+        BNB_COUNT_GL_CALLS(1);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
 
-    glBindVertexArray(m_vao);
+    BNB_COUNT_GL_CALLS(1);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+}
+
+/* renderer::update_fit_scale */
+void renderer::update_fit_scale()
+{
+    m_fit_scale[0] = 1.0f;
+    m_fit_scale[1] = 1.0f;
+    if (m_fitted_mode == fit_mode::stretch || m_fitted_texture_width <= 0 || m_fitted_texture_height <= 0
+        || m_fitted_viewport_width <= 0 || m_fitted_viewport_height <= 0) {
+        return;
+    }
+
+    auto texture_aspect = static_cast<float>(m_fitted_texture_width) / static_cast<float>(m_fitted_texture_height);
+    auto surface_aspect = static_cast<float>(m_fitted_viewport_width) / static_cast<float>(m_fitted_viewport_height);
+    // Fit shrinks the quad along the axis the frame is short of, fill grows it along the other one
+    bool is_wider = texture_aspect > surface_aspect;
+    if (m_fitted_mode == fit_mode::fit) {
+        m_fit_scale[is_wider ? 1 : 0] = is_wider ? surface_aspect / texture_aspect : texture_aspect / surface_aspect;
+    } else {
+        m_fit_scale[is_wider ? 0 : 1] = is_wider ? texture_aspect / surface_aspect : surface_aspect / texture_aspect;
+    }
+}
+
+/* renderer::apply_present_mode */
+void renderer::apply_present_mode(present_mode mode)
+{
+    switch (mode) {
+        case present_mode::vsync:
+            glfwSwapInterval(1);
+            break;
+        case present_mode::adaptive: {
+            // A negative interval swaps late frames without waiting for the next vertical blank
+            auto has_tear_control = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+            glfwSwapInterval(has_tear_control ? -1 : 1);
+            break;
+        }
+        case present_mode::immediate:
+        case present_mode::paced:
+            // The paced mode times the swaps itself, a vertical blank wait would shift them
+            glfwSwapInterval(0);
+            break;
+    }
+    m_pacing_delay_ms = 0.0;
+}
+
+/* renderer::wait_paced_present */
+void renderer::wait_paced_present(const texture_frame& frame)
+{
+    // The delay follows the slowest recent frame at once and shrinks slowly, so frames are presented
+    // at the intervals they were captured at, unless the pipeline latency changes for good
+    constexpr double max_pacing_delay_ms = 100.0;
+    constexpr double pacing_delay_decay = 0.02;
+    auto now = std::chrono::steady_clock::now();
+    auto latency_ms = std::chrono::duration<double, std::milli>(now - frame.timestamp).count();
+    if (latency_ms > m_pacing_delay_ms) {
+        m_pacing_delay_ms = std::min(latency_ms, max_pacing_delay_ms);
+    } else {
+        m_pacing_delay_ms += (latency_ms - m_pacing_delay_ms) * pacing_delay_decay;
+    }
+
+    auto due = frame.timestamp + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(m_pacing_delay_ms));
+    std::unique_lock<std::mutex> lock(m_wakeup_mutex);
+    m_wakeup_cv.wait_until(lock, due, [this]() { return !m_auto_rendering_is_running; });
+}
+
+/* renderer::account_present */
+void renderer::account_present(const texture_frame& frame)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto latency_ms = std::chrono::duration<double, std::milli>(now - frame.timestamp).count();
+
+    std::lock_guard<std::mutex> lock(m_pacing_mutex);
+    auto& s = m_pacing_statistics;
+    ++m_presents;
+    m_latency_sum_ms += latency_ms;
+    s.average_latency_ms = m_latency_sum_ms / static_cast<double>(m_presents);
+    s.max_latency_ms = std::max(s.max_latency_ms, latency_ms);
+    s.pacing_delay_ms = m_pacing_delay_ms;
+
+    if (m_last_present != std::chrono::steady_clock::time_point {}) {
+        auto interval_ms = std::chrono::duration<double, std::milli>(now - m_last_present).count();
+        auto bucket = std::min(static_cast<size_t>(interval_ms), pacing_statistics::histogram_buckets - 1);
+        ++s.interval_histogram[bucket];
+        ++s.intervals;
+        m_interval_sum_ms += interval_ms;
+        m_interval_square_sum_ms += interval_ms * interval_ms;
+        auto count = static_cast<double>(s.intervals);
+        s.average_interval_ms = m_interval_sum_ms / count;
+        s.interval_stddev_ms = std::sqrt(std::max(0.0, m_interval_square_sum_ms / count - s.average_interval_ms * s.average_interval_ms));
+    }
+    m_last_present = now;
+}
 
-    m_program->unuse();
+/* renderer::wait_frame_fence */
+void renderer::wait_frame_fence(texture_frame& frame)
+{
+    if (frame.fence == nullptr) {
+        return;
+    }
+    // Server-side wait: the render thread queues the draw immediately and the GPU
+    // holds it until the producer's commands for this texture have completed
+    BNB_COUNT_GL_CALLS(2);
+    glWaitSync(frame.fence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(frame.fence);
+    frame.fence = nullptr;
+}
+
+/* to_string */
+const char* bnb::render::to_string(fit_mode mode)
+{
+    switch (mode) {
+        case fit_mode::fit:
+            return "fit";
+        case fit_mode::fill:
+            return "fill";
+        case fit_mode::stretch:
+            return "stretch";
+    }
+    return "unknown";
+}
+
+/* to_string */
+const char* bnb::render::to_string(present_mode mode)
+{
+    switch (mode) {
+        case present_mode::vsync:
+            return "vsync";
+        case present_mode::immediate:
+            return "immediate";
+        case present_mode::adaptive:
+            return "adaptive";
+        case present_mode::paced:
+            return "paced";
+    }
+    return "unknown";
 }
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <thread>
 
 #include <glad/glad.h>
@@ -9,9 +14,32 @@
 
 #include <opengl/program.hpp>
 
+#include "texture_triple_buffer.hpp"
+
 namespace bnb::render
 {
     class renderer;
+
+    // How a frame is placed in a surface of another aspect ratio
+    enum class fit_mode
+    {
+        fit,    /* the whole frame is shown, the rest of the surface is black */
+        fill,   /* the frame covers the surface and is cropped */
+        stretch /* the frame is scaled to the surface and loses its proportions */
+    };
+
+    const char* to_string(fit_mode mode);
+
+    // When the render thread presents frames
+    enum class present_mode
+    {
+        vsync,     /* swaps wait for the vertical blank, no tearing, the render thread blocks in the swap */
+        immediate, /* swaps return at once, the lowest latency, frames may tear */
+        adaptive,  /* vsync, a late frame is swapped at once; plain vsync without swap control tear support */
+        paced      /* frames are presented a constant delay after their timestamps, keeping the camera cadence */
+    };
+
+    const char* to_string(present_mode mode);
 } /* namespace bnb::render */
 
 using renderer_sptr = std::shared_ptr<bnb::render::renderer>;
@@ -28,32 +56,155 @@ namespace bnb::render
 
         void surface_changed(int32_t width, int32_t height);
 
-        void update_texture(GLuint texture);
+        // Must be called from a single producer thread with the context that rendered the texture
+        // current, e.g. from the OEP get_texture callback. A fence is inserted into that context,
+        // and the render thread makes the GPU wait on it instead of blocking the CPU.
+        // The trace frame id is recorded as presented once the texture is swapped to the screen.
+        // The width and height of the texture fit it into the surface, the producer knows them
+        // (e.g. the OEP surface size), so the render thread does not query the shared texture.
+        // The timestamp is when the frame entered the pipeline, e.g. when the camera delivered it;
+        // the paced present mode keeps the intervals between timestamps. Publish time if not set.
+        void update_texture(GLuint texture, int32_t width, int32_t height, uint64_t trace_frame = 0, std::chrono::steady_clock::time_point timestamp = {});
 
         void start_auto_rendering(GLFWwindow* window);
 
         void stop_auto_rendering();
 
+        struct pacing_statistics
+        {
+            static constexpr size_t histogram_buckets = 64;
+
+            // Intervals between presentations of new frames in 1 ms buckets, the last one holds the longer ones
+            std::array<uint64_t, histogram_buckets> interval_histogram {};
+            uint64_t intervals {0};
+            double average_interval_ms {0.0};
+            double interval_stddev_ms {0.0};
+            // From the frame timestamp until the swap returned
+            double average_latency_ms {0.0};
+            double max_latency_ms {0.0};
+            // Delay between timestamps and presentation kept by the paced mode
+            double pacing_delay_ms {0.0};
+        };
+
+        // Vsync by default, may be changed while rendering
+        void set_present_mode(present_mode mode);
+
+        [[nodiscard]] present_mode get_present_mode() const
+        {
+            return m_present_mode;
+        }
+
+        pacing_statistics get_pacing_statistics() const;
+
+        // Applied from the next presented frame, fit by default. Only the quad the frame is
+        // drawn with changes, the OEP keeps rendering in its own size.
+        void set_fit_mode(fit_mode mode);
+
+        [[nodiscard]] fit_mode get_fit_mode() const
+        {
+            return m_fit_mode;
+        }
+
+        // The render thread sleeps until a new texture or a surface change arrives.
+        // The timeout only bounds the sleep, an expired timeout does not present a frame.
+        void set_idle_timeout(std::chrono::milliseconds timeout);
+
+        // Number of times the render thread woke up, including idle timeouts
+        [[nodiscard]] uint64_t get_wakeups_count() const
+        {
+            return m_wakeups_count;
+        }
+
+        // Number of frames passed to glfwSwapBuffers
+        [[nodiscard]] uint64_t get_presented_frames_count() const
+        {
+            return m_presented_frames_count;
+        }
+
+        // GL calls issued by the render thread to present frames, including fence waits and swaps.
+        // Counted in debug builds only, zero otherwise.
+        [[nodiscard]] uint64_t get_gl_calls_count() const
+        {
+            return m_gl_calls_count;
+        }
+
+        // Number of textures overwritten by a newer one before the render thread picked them up
+        [[nodiscard]] uint64_t get_dropped_frames_count() const
+        {
+            return m_frames.get_dropped_frames_count();
+        }
+
+        // Number of times the last texture was presented again, e.g. after a surface change
+        [[nodiscard]] uint64_t get_duplicated_frames_count() const
+        {
+            return m_frames.get_duplicated_frames_count();
+        }
+
     private:
         void initialize();
 
         void shutdown();
 
-        void draw_texture(GLuint texture);
+        void draw_texture(const texture_frame& frame);
+
+        void wait_frame_fence(texture_frame& frame);
+
+        // Scale of the quad for the fitted frame, surface and mode
+        void update_fit_scale();
+
+        // Sets the swap interval of the mode, called on the render thread
+        void apply_present_mode(present_mode mode);
+
+        // In the paced mode waits until the frame is due
+        void wait_paced_present(const texture_frame& frame);
+
+        void account_present(const texture_frame& frame);
 
     private:
         std::thread m_auto_rendering_thread;
+        std::mutex m_wakeup_mutex;
+        std::condition_variable m_wakeup_cv;
+        std::atomic<std::chrono::milliseconds::rep> m_idle_timeout_ms {100};
 
         std::unique_ptr<bnb::oep::program> m_program {nullptr};
 
         int32_t m_width {0};
         int32_t m_height {0};
-        GLuint m_texture_id {0};
+        // Size of the viewport, used by the render thread only
+        int32_t m_viewport_width {0};
+        int32_t m_viewport_height {0};
+        GLint m_scale_location {-1};
+        std::atomic<present_mode> m_present_mode {present_mode::vsync};
+        double m_pacing_delay_ms {0.0};
+        std::chrono::steady_clock::time_point m_last_present {};
+        mutable std::mutex m_pacing_mutex;
+        pacing_statistics m_pacing_statistics;
+        uint64_t m_presents {0};
+        double m_interval_sum_ms {0.0};
+        double m_interval_square_sum_ms {0.0};
+        double m_latency_sum_ms {0.0};
+
+        std::atomic<fit_mode> m_fit_mode {fit_mode::fit};
+        // What the quad scale was computed for, the render thread recomputes it only when they change
+        fit_mode m_fitted_mode {fit_mode::stretch};
+        int32_t m_fitted_texture_width {0};
+        int32_t m_fitted_texture_height {0};
+        int32_t m_fitted_viewport_width {0};
+        int32_t m_fitted_viewport_height {0};
+        float m_fit_scale[2] {1.0f, 1.0f};
+        texture_triple_buffer m_frames;
+        uint64_t m_frame_sequence {0};
         GLuint m_vao {0};
         GLuint m_vbo {0};
+        GLuint m_sampler {0};
+        // The quad scale uniform is uploaded again only when the scale changes
+        bool m_fit_scale_uploaded {false};
 
         std::atomic_bool m_auto_rendering_is_running {false};
-        std::atomic_bool m_texture_updated {false};
         std::atomic_bool m_surface_changed {false};
+
+        std::atomic_uint64_t m_wakeups_count {0};
+        std::atomic_uint64_t m_presented_frames_count {0};
+        std::atomic_uint64_t m_gl_calls_count {0};
     };
 } // namespace bnb::render
@@ -0,0 +1,263 @@
+#include "texture_readback.hpp"
+
+#include "pixel_conversion.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace bnb::render;
+
+namespace
+{
+    using image_format = bnb::oep::interfaces::image_format;
+
+    bool is_rgba(image_format format)
+    {
+        return format == image_format::bpc8_rgba || format == image_format::bpc8_bgra;
+    }
+
+    bool is_yuv(image_format format)
+    {
+        switch (format) {
+            case image_format::nv12_bt601_full:
+            case image_format::nv12_bt601_video:
+            case image_format::nv12_bt709_full:
+            case image_format::nv12_bt709_video:
+            case image_format::i420_bt601_full:
+            case image_format::i420_bt601_video:
+            case image_format::i420_bt709_full:
+            case image_format::i420_bt709_video:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    size_t get_readback_size(image_format format, int32_t width, int32_t height)
+    {
+        if (is_rgba(format)) {
+            return static_cast<size_t>(width) * height * 4;
+        }
+        // Luma and interleaved chroma, as rendered by yuv_converter
+        return static_cast<size_t>(width) * height + static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2) * 2;
+    }
+
+} /* namespace */
+
+/* texture_readback::texture_readback */
+texture_readback::texture_readback(bnb::oep::interfaces::image_format output_format, int32_t ring_size)
+    : m_output_format(output_format)
+    , m_read_format(output_format == image_format::bpc8_bgra ? GL_BGRA : GL_RGBA)
+    , m_slots(static_cast<size_t>(std::max(1, ring_size)))
+{
+    if (!is_rgba(output_format) && !is_yuv(output_format)) {
+        throw std::invalid_argument("texture_readback supports RGBA, BGRA, NV12 and I420 output");
+    }
+}
+
+/* texture_readback::read */
+void texture_readback::read(GLuint texture, int32_t width, int32_t height, readback_cb callback)
+{
+    if (m_fbo == 0) {
+        initialize();
+    }
+
+    poll();
+    if (m_queued == m_slots.size()) {
+        {
+            std::lock_guard<std::mutex> lock(m_statistics_mutex);
+            ++m_statistics.ring_stalls;
+        }
+        deliver_oldest(true);
+    }
+
+    auto& s = m_slots[(m_oldest + m_queued) % m_slots.size()];
+    s.width = width;
+    s.height = height;
+    s.callback = std::move(callback);
+    s.start = clock::now();
+
+    // The OEP keeps its own bindings, they are restored after the readback is queued
+    GLint previous_fbo = 0;
+    GLint previous_pbo = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_fbo);
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &previous_pbo);
+
+    auto size = get_readback_size(m_output_format, width, height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    if (s.capacity != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+        s.capacity = size;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    if (is_rgba(m_output_format)) {
+        read_plane(texture, m_read_format, width, height, 0);
+    } else {
+        // YUV planes are rendered on the GPU, so only 1.5 bytes per pixel are read back
+        m_converter.convert(texture, width, height, m_output_format);
+        read_plane(m_converter.get_luma_texture(), GL_RED, width, height, 0);
+        read_plane(m_converter.get_chroma_texture(), GL_RG, (width + 1) / 2, (height + 1) / 2, static_cast<size_t>(width) * height);
+    }
+
+    s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Submits the commands, so the fence is signaled without another GL call from this thread
+    glFlush();
+    ++m_queued;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous_fbo));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(previous_pbo));
+}
+
+/* texture_readback::read_plane */
+void texture_readback::read_plane(GLuint texture, GLenum format, int32_t width, int32_t height, size_t offset)
+{
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    // With a pack buffer bound the pixels go into it at the offset and the call returns without waiting
+    glReadPixels(0, 0, width, height, format, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(offset));
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+}
+
+/* texture_readback::poll */
+void texture_readback::poll()
+{
+    while (m_queued > 0 && deliver_oldest(false)) {
+    }
+}
+
+/* texture_readback::flush */
+void texture_readback::flush()
+{
+    while (m_queued > 0) {
+        deliver_oldest(true);
+    }
+}
+
+/* texture_readback::release */
+void texture_readback::release()
+{
+    // Queued readbacks are still delivered, their callbacks may hold frame slots
+    flush();
+
+    for (auto& s : m_slots) {
+        if (s.pbo != 0) {
+            glDeleteBuffers(1, &s.pbo);
+            s.pbo = 0;
+            s.capacity = 0;
+        }
+    }
+    if (m_fbo != 0) {
+        glDeleteFramebuffers(1, &m_fbo);
+        m_fbo = 0;
+    }
+    m_converter.release();
+}
+
+/* texture_readback::get_statistics */
+texture_readback::statistics texture_readback::get_statistics() const
+{
+    std::lock_guard<std::mutex> lock(m_statistics_mutex);
+    return m_statistics;
+}
+
+/* texture_readback::initialize */
+void texture_readback::initialize()
+{
+    glGenFramebuffers(1, &m_fbo);
+    for (auto& s : m_slots) {
+        glGenBuffers(1, &s.pbo);
+    }
+}
+
+/* texture_readback::deliver_oldest */
+bool texture_readback::deliver_oldest(bool wait)
+{
+    auto& s = m_slots[m_oldest];
+
+    if (wait) {
+        // Commands were flushed in read(), the loop only guards against spurious timeouts
+        GLenum status = GL_TIMEOUT_EXPIRED;
+        while (status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(s.fence, 0, 100'000'000);
+        }
+    } else if (glClientWaitSync(s.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    glDeleteSync(s.fence);
+    s.fence = nullptr;
+
+    auto copy_start = clock::now();
+    GLint previous_pbo = 0;
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &previous_pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    pixel_buffer_sptr image;
+    if (auto pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(s.capacity), GL_MAP_READ_BIT)) {
+        image = copy_pixels(static_cast<const uint8_t*>(pixels), s.width, s.height);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(previous_pbo));
+
+    auto now = clock::now();
+    auto latency_ms = std::chrono::duration<double, std::milli>(now - s.start).count();
+    auto copy_ms = std::chrono::duration<double, std::milli>(now - copy_start).count();
+    {
+        std::lock_guard<std::mutex> lock(m_statistics_mutex);
+        if (image != nullptr) {
+            ++m_statistics.frames_read;
+            m_statistics.bytes_read += s.capacity;
+            m_total_latency_ms += latency_ms;
+            m_total_copy_ms += copy_ms;
+            m_statistics.max_latency_ms = std::max(m_statistics.max_latency_ms, latency_ms);
+            m_statistics.average_latency_ms = m_total_latency_ms / static_cast<double>(m_statistics.frames_read);
+            m_statistics.average_copy_ms = m_total_copy_ms / static_cast<double>(m_statistics.frames_read);
+        } else {
+            ++m_statistics.frames_failed;
+        }
+    }
+
+    // The slot is released before the callback, which may queue the next readback
+    auto callback = std::move(s.callback);
+    s.callback = nullptr;
+    m_oldest = (m_oldest + 1) % m_slots.size();
+    --m_queued;
+    if (callback) {
+        callback(image);
+    }
+    return true;
+}
+
+/* texture_readback::copy_pixels */
+pixel_buffer_sptr texture_readback::copy_pixels(const uint8_t* pixels, int32_t width, int32_t height)
+{
+    auto image = m_pool->acquire(m_output_format, width, height);
+    if (image == nullptr) {
+        return nullptr;
+    }
+
+    auto copy_plane = [](const uint8_t* src, size_t row_size, int32_t rows, uint8_t* dst, size_t dst_stride) {
+        for (int32_t row = 0; row < rows; ++row) {
+            std::memcpy(dst + row * dst_stride, src + row * row_size, row_size);
+        }
+    };
+
+    if (is_rgba(m_output_format)) {
+        copy_plane(pixels, static_cast<size_t>(width) * 4, height, image->get_base_sptr_of_plane(0).get(), image->get_bytes_per_row_of_plane(0));
+        return image;
+    }
+
+    copy_plane(pixels, static_cast<size_t>(width), height, image->get_base_sptr_of_plane(0).get(), image->get_bytes_per_row_of_plane(0));
+    auto chroma = pixels + static_cast<size_t>(width) * height;
+    auto chroma_row_size = static_cast<int32_t>((width + 1) / 2 * 2);
+    if (image->get_number_of_planes() == 2) {
+        copy_plane(chroma, chroma_row_size, (height + 1) / 2, image->get_base_sptr_of_plane(1).get(), image->get_bytes_per_row_of_plane(1));
+    } else {
+        bnb::conversion::get_kernels().nv12_to_i420(
+            chroma, chroma_row_size,
+            image->get_base_sptr_of_plane(1).get(), image->get_bytes_per_row_of_plane(1),
+            image->get_base_sptr_of_plane(2).get(), image->get_bytes_per_row_of_plane(2),
+            width, height);
+    }
+    return image;
+}
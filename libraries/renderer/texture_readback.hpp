@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "pixel_buffer_pool.hpp"
+#include "yuv_converter.hpp"
+
+namespace bnb::render
+{
+    // Copies RGBA textures into pixel buffers in CPU memory without stalling the GL pipeline.
+    // read() only queues glReadPixels into a pixel pack buffer of a ring and fences it, the buffer
+    // is mapped on a later call once the fence is signaled, so frame N is copied out while frames
+    // N+1 and N+2 are still rendered. All calls must be made on one thread with the same GL
+    // context current, e.g. in OEP get_texture callbacks.
+    class texture_readback
+    {
+    public:
+        // The pixel buffer is nullptr if the readback failed. Called from read(), poll() or flush().
+        using readback_cb = std::function<void(pixel_buffer_sptr image)>;
+
+        struct statistics
+        {
+            uint64_t frames_read {0};
+            uint64_t frames_failed {0};
+            // Reads which found the ring full and waited for the GPU to finish the oldest one
+            uint64_t ring_stalls {0};
+            uint64_t bytes_read {0};
+            // From read() to the callback
+            double average_latency_ms {0.0};
+            double max_latency_ms {0.0};
+            // Mapping the pack buffer and copying it into the pixel buffer
+            double average_copy_ms {0.0};
+        };
+
+        // Output may be bpc8_rgba, bpc8_bgra, or an NV12 or I420 format which the texture is
+        // converted into on the GPU by yuv_converter. Throws std::invalid_argument for other formats.
+        explicit texture_readback(bnb::oep::interfaces::image_format output_format, int32_t ring_size = 3);
+
+        // GL objects are not deleted here, since the context may not be current, see release()
+        ~texture_readback() = default;
+
+        texture_readback(const texture_readback&) = delete;
+        texture_readback& operator=(const texture_readback&) = delete;
+
+        // Queues the readback of an RGBA texture of the given size and delivers finished ones
+        void read(GLuint texture, int32_t width, int32_t height, readback_cb callback);
+
+        // Delivers the readbacks finished by the GPU, does not wait
+        void poll();
+
+        // Waits for all queued readbacks and delivers them, e.g. after the last frame
+        void flush();
+
+        // Delivers the queued readbacks and deletes the GL objects, the next read() creates them again
+        void release();
+
+        [[nodiscard]] bnb::oep::interfaces::image_format get_output_format() const
+        {
+            return m_output_format;
+        }
+
+        // Readbacks which may be queued at once
+        [[nodiscard]] int32_t get_ring_size() const
+        {
+            return static_cast<int32_t>(m_slots.size());
+        }
+
+        statistics get_statistics() const;
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct slot
+        {
+            GLuint pbo {0};
+            size_t capacity {0};
+            GLsync fence {nullptr};
+            int32_t width {0};
+            int32_t height {0};
+            readback_cb callback;
+            clock::time_point start;
+        };
+
+        void initialize();
+
+        // Delivers the oldest queued readback, waiting for its fence if wait is set.
+        // Returns false if it is not finished and wait is not set.
+        bool deliver_oldest(bool wait);
+
+        void read_plane(GLuint texture, GLenum format, int32_t width, int32_t height, size_t offset);
+
+        pixel_buffer_sptr copy_pixels(const uint8_t* pixels, int32_t width, int32_t height);
+
+    private:
+        const bnb::oep::interfaces::image_format m_output_format;
+        const GLenum m_read_format;
+        pixel_buffer_pool_sptr m_pool {pixel_buffer_pool::create()};
+
+        std::vector<slot> m_slots;
+        size_t m_oldest {0};
+        size_t m_queued {0};
+        GLuint m_fbo {0};
+        yuv_converter m_converter;
+
+        mutable std::mutex m_statistics_mutex;
+        statistics m_statistics;
+        double m_total_latency_ms {0.0};
+        double m_total_copy_ms {0.0};
+    };
+} // namespace bnb::render
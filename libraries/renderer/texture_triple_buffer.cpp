@@ -0,0 +1,30 @@
+#include "texture_triple_buffer.hpp"
+
+using namespace bnb::render;
+
+/* texture_triple_buffer::publish */
+std::optional<texture_frame> texture_triple_buffer::publish(const texture_frame& frame)
+{
+    m_slots[m_back] = frame;
+    auto prev = m_middle.exchange(static_cast<uint8_t>(m_back | dirty_bit), std::memory_order_acq_rel);
+    m_back = prev & index_mask;
+
+    if (prev & dirty_bit) {
+        ++m_dropped_frames_count;
+        return m_slots[m_back];
+    }
+    return std::nullopt;
+}
+
+/* texture_triple_buffer::consume */
+texture_frame& texture_triple_buffer::consume(bool& is_new)
+{
+    is_new = has_new_frame();
+    if (is_new) {
+        auto prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = prev & index_mask;
+    } else {
+        ++m_duplicated_frames_count;
+    }
+    return m_slots[m_front];
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include <glad/glad.h>
+
+namespace bnb::render
+{
+    struct texture_frame
+    {
+        GLuint texture {0};
+        uint64_t sequence {0};
+        GLsync fence {nullptr};
+        uint64_t trace_frame {0}; /* bnb::trace frame id, zero if the frame is not traced */
+        std::chrono::steady_clock::time_point timestamp {}; /* when the frame entered the pipeline, for pacing */
+        int32_t width {0};  /* texture size, passed by the producer so the render thread does not query it */
+        int32_t height {0};
+    };
+
+    // Latest-wins triple buffer for handing textures from a single producer thread
+    // to a single consumer thread. Neither side takes a lock or waits for the other:
+    // the producer always has a free slot to write, and the consumer always reads the
+    // most recent complete frame.
+    class texture_triple_buffer
+    {
+    public:
+        texture_triple_buffer() = default;
+
+        // Producer side. Returns the previously published frame if the consumer never picked it up,
+        // so the caller can release resources attached to it (e.g. the fence).
+        std::optional<texture_frame> publish(const texture_frame& frame);
+
+        // Consumer side. Returns the newest published frame. If nothing was published since
+        // the previous call, the previous frame is returned again and counted as duplicated.
+        // The returned reference stays valid and owned by the consumer until the next call.
+        texture_frame& consume(bool& is_new);
+
+        [[nodiscard]] bool has_new_frame() const
+        {
+            return (m_middle.load(std::memory_order_acquire) & dirty_bit) != 0;
+        }
+
+        [[nodiscard]] uint64_t get_dropped_frames_count() const
+        {
+            return m_dropped_frames_count;
+        }
+
+        [[nodiscard]] uint64_t get_duplicated_frames_count() const
+        {
+            return m_duplicated_frames_count;
+        }
+
+    private:
+        static constexpr uint8_t index_mask = 0b011;
+        static constexpr uint8_t dirty_bit = 0b100;
+
+        std::array<texture_frame, 3> m_slots {};
+
+        uint8_t m_back {0};              /* owned by the producer */
+        std::atomic_uint8_t m_middle {1}; /* shared, slot index plus dirty bit */
+        uint8_t m_front {2};             /* owned by the consumer */
+
+        std::atomic_uint64_t m_dropped_frames_count {0};
+        std::atomic_uint64_t m_duplicated_frames_count {0};
+    }; /* class texture_triple_buffer */
+
+} /* namespace bnb::render */
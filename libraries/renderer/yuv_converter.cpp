@@ -0,0 +1,263 @@
+#include "yuv_converter.hpp"
+
+using namespace bnb::render;
+
+namespace
+{
+    using image_format = bnb::oep::interfaces::image_format;
+
+    // Rows of the RGB to YUV matrix with the offset in the last component, in normalized units
+    struct yuv_coefficients
+    {
+        float y[4];
+        float u[4];
+        float v[4];
+    };
+
+    yuv_coefficients make_yuv_coefficients(image_format format)
+    {
+        bool bt709 = false;
+        bool full_range = false;
+        switch (format) {
+            case image_format::nv12_bt601_full:
+            case image_format::i420_bt601_full:
+                full_range = true;
+                break;
+            case image_format::nv12_bt709_full:
+            case image_format::i420_bt709_full:
+                bt709 = true;
+                full_range = true;
+                break;
+            case image_format::nv12_bt709_video:
+            case image_format::i420_bt709_video:
+                bt709 = true;
+                break;
+            default:
+                break;
+        }
+
+        const float kr = bt709 ? 0.2126f : 0.299f;
+        const float kb = bt709 ? 0.0722f : 0.114f;
+        const float kg = 1.0f - kr - kb;
+        const float y_scale = full_range ? 1.0f : 219.0f / 255.0f;
+        const float uv_scale = full_range ? 1.0f : 224.0f / 255.0f;
+        const float y_offset = full_range ? 0.0f : 16.0f / 255.0f;
+        const float uv_offset = 128.0f / 255.0f;
+
+        return {
+            {kr * y_scale, kg * y_scale, kb * y_scale, y_offset},
+            {-kr / (2.0f * (1.0f - kb)) * uv_scale, -kg / (2.0f * (1.0f - kb)) * uv_scale, 0.5f * uv_scale, uv_offset},
+            {0.5f * uv_scale, -kg / (2.0f * (1.0f - kr)) * uv_scale, -kb / (2.0f * (1.0f - kr)) * uv_scale, uv_offset},
+        };
+    }
+
+} /* namespace */
+
+/* yuv_converter::convert */
+void yuv_converter::convert(GLuint texture, int32_t width, int32_t height, bnb::oep::interfaces::image_format format)
+{
+    if (m_program == nullptr) {
+        initialize();
+    }
+    if (width != m_width || height != m_height) {
+        allocate_planes(width, height);
+    }
+
+    // The OEP keeps its own state in the context, everything changed here is restored
+    GLint previous_program = 0;
+    GLint previous_fbo = 0;
+    GLint previous_vao = 0;
+    GLint previous_active_texture = 0;
+    GLint previous_texture = 0;
+    GLint previous_sampler = 0;
+    GLint previous_viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previous_program);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_fbo);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_vao);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &previous_active_texture);
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+    glGetIntegerv(GL_SAMPLER_BINDING, &previous_sampler);
+    glGetIntegerv(GL_VIEWPORT, previous_viewport);
+    auto is_blend_enabled = glIsEnabled(GL_BLEND);
+    auto is_depth_test_enabled = glIsEnabled(GL_DEPTH_TEST);
+    auto is_scissor_test_enabled = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+
+    m_program->use();
+    glUniform2f(m_texture_size_location, static_cast<float>(width), static_cast<float>(height));
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // Filtering is set by the sampler, the parameters of the OEP texture stay untouched
+    glBindSampler(0, m_sampler);
+    glBindVertexArray(m_vao);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo);
+
+    auto coefficients = make_yuv_coefficients(format);
+    glUniform4fv(m_y_location, 1, coefficients.y);
+    glUniform4fv(m_u_location, 1, coefficients.u);
+    glUniform4fv(m_v_location, 1, coefficients.v);
+    draw_plane(m_luma_texture, width, height, false);
+    draw_plane(m_chroma_texture, (width + 1) / 2, (height + 1) / 2, true);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+    m_program->unuse();
+    glUseProgram(static_cast<GLuint>(previous_program));
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(previous_fbo));
+    glBindVertexArray(static_cast<GLuint>(previous_vao));
+    glBindSampler(0, static_cast<GLuint>(previous_sampler));
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+    glActiveTexture(static_cast<GLenum>(previous_active_texture));
+    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+    if (is_blend_enabled) {
+        glEnable(GL_BLEND);
+    }
+    if (is_depth_test_enabled) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    if (is_scissor_test_enabled) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+}
+
+/* yuv_converter::release */
+void yuv_converter::release()
+{
+    if (m_luma_texture != 0) {
+        glDeleteTextures(1, &m_luma_texture);
+        m_luma_texture = 0;
+    }
+    if (m_chroma_texture != 0) {
+        glDeleteTextures(1, &m_chroma_texture);
+        m_chroma_texture = 0;
+    }
+    m_width = 0;
+    m_height = 0;
+    if (m_sampler != 0) {
+        glDeleteSamplers(1, &m_sampler);
+        m_sampler = 0;
+    }
+    if (m_fbo != 0) {
+        glDeleteFramebuffers(1, &m_fbo);
+        m_fbo = 0;
+    }
+    if (m_vao != 0) {
+        glDeleteVertexArrays(1, &m_vao);
+        m_vao = 0;
+    }
+    if (m_vbo != 0) {
+        glDeleteBuffers(1, &m_vbo);
+        m_vbo = 0;
+    }
+    m_program = nullptr;
+}
+
+/* yuv_converter::initialize */
+void yuv_converter::initialize()
+{
+    // clang-format off
+    static const char* vertex_shader_program =
+        "precision highp float;\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "void main() {\n"
+        "  gl_Position = vec4(aPos, 1.0);\n"
+        "}\n";
+
+    // Luma is fetched per pixel. A chroma pixel covers a 2x2 block of the source, sampling at the
+    // center of the block with bilinear filtering averages the four pixels in one fetch.
+    static const char* fragment_shader_program =
+        "precision highp float;\n"
+        "out vec4 FragColor;\n"
+        "uniform sampler2D uTexture;\n"
+        "uniform vec2 uTextureSize;\n"
+        "uniform bool uIsChroma;\n"
+        "uniform vec4 uY;\n"
+        "uniform vec4 uU;\n"
+        "uniform vec4 uV;\n"
+        "void main() {\n"
+        "  if (uIsChroma) {\n"
+        "    vec3 rgb = texture(uTexture, 2.0 * gl_FragCoord.xy / uTextureSize).rgb;\n"
+        "    FragColor = vec4(dot(rgb, uU.xyz) + uU.w, dot(rgb, uV.xyz) + uV.w, 0.0, 1.0);\n"
+        "  } else {\n"
+        "    vec3 rgb = texelFetch(uTexture, ivec2(gl_FragCoord.xy), 0).rgb;\n"
+        "    FragColor = vec4(dot(rgb, uY.xyz) + uY.w, 0.0, 0.0, 1.0);\n"
+        "  }\n"
+        "}\n";
+
+    static const float drawing_plane_coords[] = {
+        1.0f, 1.0f, 0.0f,   /* top right */
+        1.0f, -1.0f, 0.0f,  /* bottom right */
+        -1.0f, 1.0f, 0.0f,  /* top left */
+        -1.0f, -1.0f, 0.0f, /* bottom left */
+    };
+    // clang-format on
+
+    m_program = std::make_unique<bnb::oep::program>("yuv_converter", vertex_shader_program, fragment_shader_program);
+
+    // The program class does not expose its id, it is taken from the bound program
+    GLint previous_program = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previous_program);
+    m_program->use();
+    GLint program_id = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program_id);
+    glUniform1i(glGetUniformLocation(program_id, "uTexture"), 0);
+    m_texture_size_location = glGetUniformLocation(program_id, "uTextureSize");
+    m_is_chroma_location = glGetUniformLocation(program_id, "uIsChroma");
+    m_y_location = glGetUniformLocation(program_id, "uY");
+    m_u_location = glGetUniformLocation(program_id, "uU");
+    m_v_location = glGetUniformLocation(program_id, "uV");
+    m_program->unuse();
+    glUseProgram(static_cast<GLuint>(previous_program));
+
+    GLint previous_vao = 0;
+    GLint previous_vbo = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_vao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previous_vbo);
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(drawing_plane_coords), drawing_plane_coords, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(static_cast<GLuint>(previous_vao));
+    glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previous_vbo));
+
+    glGenFramebuffers(1, &m_fbo);
+
+    glGenSamplers(1, &m_sampler);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+/* yuv_converter::allocate_planes */
+void yuv_converter::allocate_planes(int32_t width, int32_t height)
+{
+    if (m_luma_texture == 0) {
+        glGenTextures(1, &m_luma_texture);
+        glGenTextures(1, &m_chroma_texture);
+    }
+
+    GLint previous_texture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+    glBindTexture(GL_TEXTURE_2D, m_luma_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, m_chroma_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, (width + 1) / 2, (height + 1) / 2, 0, GL_RG, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+
+    m_width = width;
+    m_height = height;
+}
+
+/* yuv_converter::draw_plane */
+void yuv_converter::draw_plane(GLuint target, int32_t width, int32_t height, bool is_chroma)
+{
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    glViewport(0, 0, width, height);
+    glUniform1i(m_is_chroma_location, is_chroma ? 1 : 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <glad/glad.h>
+
+#include <interfaces/image_format.hpp>
+#include <opengl/program.hpp>
+
+namespace bnb::render
+{
+    // Converts an RGBA texture into NV12 planes on the GPU: luma into an R8 texture of the same
+    // size and interleaved chroma into an RG8 texture of half the size, so only 1.5 bytes per pixel
+    // have to be read back. Chroma of every 2x2 block is its average color, taken with a single
+    // bilinear fetch. The color standard and range follow the NV12 or I420 output format.
+    // All calls must be made on one thread with the same GL context current.
+    class yuv_converter
+    {
+    public:
+        yuv_converter() = default;
+
+        // GL objects are not deleted here, since the context may not be current, see release()
+        ~yuv_converter() = default;
+
+        yuv_converter(const yuv_converter&) = delete;
+        yuv_converter& operator=(const yuv_converter&) = delete;
+
+        // Renders the planes, the GL state the conversion changes is restored afterwards
+        void convert(GLuint texture, int32_t width, int32_t height, bnb::oep::interfaces::image_format format);
+
+        [[nodiscard]] GLuint get_luma_texture() const
+        {
+            return m_luma_texture;
+        }
+
+        [[nodiscard]] GLuint get_chroma_texture() const
+        {
+            return m_chroma_texture;
+        }
+
+        // Deletes the GL objects, the next convert() creates them again
+        void release();
+
+    private:
+        void initialize();
+
+        void allocate_planes(int32_t width, int32_t height);
+
+        void draw_plane(GLuint target, int32_t width, int32_t height, bool is_chroma);
+
+    private:
+        std::unique_ptr<bnb::oep::program> m_program {nullptr};
+        GLint m_texture_size_location {-1};
+        GLint m_is_chroma_location {-1};
+        GLint m_y_location {-1};
+        GLint m_u_location {-1};
+        GLint m_v_location {-1};
+
+        GLuint m_vao {0};
+        GLuint m_vbo {0};
+        GLuint m_fbo {0};
+        GLuint m_sampler {0};
+        GLuint m_luma_texture {0};
+        GLuint m_chroma_texture {0};
+        int32_t m_width {0};
+        int32_t m_height {0};
+    };
+} // namespace bnb::render
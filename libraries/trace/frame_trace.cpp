@@ -0,0 +1,240 @@
+#include "frame_trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+    using namespace bnb::trace;
+
+    // 32768 events keep about two minutes of a 30 fps stream with every stage recorded
+    constexpr size_t ring_capacity = size_t {1} << 15;
+    constexpr size_t tag_capacity = 64;
+
+    // A ring slot is a tiny seqlock: the sequence is zero while the slot is written and the
+    // event index plus one once it is complete, so readers can detect torn or recycled slots
+    struct event_slot
+    {
+        std::atomic<uint64_t> sequence {0};
+        std::atomic<uint64_t> frame {0};
+        std::atomic<int64_t> timestamp_us {0};
+        std::atomic<uint32_t> thread {0};
+        std::atomic<uint8_t> stage {0};
+    };
+
+    struct tag_slot
+    {
+        std::atomic<const void*> object {nullptr};
+        std::atomic<uint64_t> frame {0};
+    };
+
+    struct event
+    {
+        uint64_t frame;
+        int64_t timestamp_us;
+        uint32_t thread;
+        stage s;
+    };
+
+    std::array<event_slot, ring_capacity> ring;
+    std::atomic<uint64_t> ring_head {0};
+    std::array<tag_slot, tag_capacity> tags;
+    std::atomic<uint64_t> tag_cursor {0};
+    std::atomic<uint64_t> last_frame {0};
+    std::atomic<uint32_t> last_thread {0};
+    std::atomic_bool enabled {true};
+    const auto epoch = std::chrono::steady_clock::now();
+
+    uint32_t current_thread()
+    {
+        // Small sequential numbers read better in trace viewers than hashed native ids
+        thread_local const uint32_t thread = ++last_thread;
+        return thread;
+    }
+
+    int64_t now_us()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    std::vector<event> collect_events()
+    {
+        std::vector<event> events;
+        auto head = ring_head.load(std::memory_order_acquire);
+        auto first = head > ring_capacity ? head - ring_capacity : 0;
+        events.reserve(static_cast<size_t>(head - first));
+
+        for (auto index = first; index < head; ++index) {
+            auto& slot = ring[index % ring_capacity];
+            if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+                continue;
+            }
+            event e {
+                slot.frame.load(std::memory_order_relaxed),
+                slot.timestamp_us.load(std::memory_order_relaxed),
+                slot.thread.load(std::memory_order_relaxed),
+                static_cast<stage>(slot.stage.load(std::memory_order_relaxed))};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == index + 1) {
+                events.push_back(e);
+            }
+        }
+        return events;
+    }
+
+    void write_event(std::ofstream& file, bool& first, const char* name, const char* phase, int64_t ts, uint32_t thread, uint64_t frame)
+    {
+        file << (first ? "\n" : ",\n") << "{\"name\":\"" << name << "\",\"cat\":\"frame\",\"ph\":\"" << phase
+             << "\",\"ts\":" << ts << ",\"pid\":1,\"tid\":" << thread;
+        if (phase[0] == 'i') {
+            file << ",\"s\":\"t\",\"args\":{\"frame\":" << frame << "}}";
+        } else {
+            file << ",\"id\":" << frame << "}";
+        }
+        first = false;
+    }
+
+} /* namespace */
+
+namespace bnb::trace
+{
+
+    /* begin_frame */
+    frame_id begin_frame()
+    {
+        return ++last_frame;
+    }
+
+    /* record */
+    void record(frame_id frame, stage s)
+    {
+        if (frame == no_frame || !enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        auto index = ring_head.fetch_add(1, std::memory_order_relaxed);
+        auto& slot = ring[index % ring_capacity];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.frame.store(frame, std::memory_order_relaxed);
+        slot.timestamp_us.store(now_us(), std::memory_order_relaxed);
+        slot.thread.store(current_thread(), std::memory_order_relaxed);
+        slot.stage.store(static_cast<uint8_t>(s), std::memory_order_relaxed);
+        slot.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    /* tag */
+    void tag(const void* object, frame_id frame)
+    {
+        if (object == nullptr || frame == no_frame) {
+            return;
+        }
+        auto& slot = tags[tag_cursor.fetch_add(1, std::memory_order_relaxed) % tag_capacity];
+        slot.object.store(nullptr, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.frame.store(frame, std::memory_order_relaxed);
+        slot.object.store(object, std::memory_order_release);
+    }
+
+    /* find */
+    frame_id find(const void* object)
+    {
+        frame_id newest = no_frame;
+        for (auto& slot : tags) {
+            if (slot.object.load(std::memory_order_acquire) != object) {
+                continue;
+            }
+            auto frame = slot.frame.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.object.load(std::memory_order_relaxed) == object) {
+                newest = std::max(newest, frame);
+            }
+        }
+        return newest;
+    }
+
+    /* set_enabled */
+    void set_enabled(bool is_enabled)
+    {
+        enabled = is_enabled;
+    }
+
+    /* is_enabled */
+    bool is_enabled()
+    {
+        return enabled;
+    }
+
+    /* dump_chrome_json */
+    int64_t dump_chrome_json(const std::string& path)
+    {
+        std::ofstream file(path);
+        if (!file) {
+            return -1;
+        }
+
+        auto events = collect_events();
+        std::stable_sort(events.begin(), events.end(), [](const event& a, const event& b) {
+            return a.frame != b.frame ? a.frame < b.frame : a.timestamp_us < b.timestamp_us;
+        });
+
+        // Every stage is an instant event on the thread that recorded it. Frames additionally get
+        // an async span from the first to the last recorded stage, split into spans between stages.
+        bool first = true;
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for (size_t begin = 0; begin < events.size();) {
+            auto end = begin;
+            while (end < events.size() && events[end].frame == events[begin].frame) {
+                ++end;
+            }
+
+            auto frame = events[begin].frame;
+            for (auto i = begin; i < end; ++i) {
+                write_event(file, first, to_string(events[i].s), "i", events[i].timestamp_us, events[i].thread, frame);
+            }
+            if (end - begin > 1) {
+                write_event(file, first, "frame", "b", events[begin].timestamp_us, events[begin].thread, frame);
+                for (auto i = begin + 1; i < end; ++i) {
+                    auto name = std::string(to_string(events[i - 1].s)) + " -> " + to_string(events[i].s);
+                    write_event(file, first, name.c_str(), "b", events[i - 1].timestamp_us, events[i - 1].thread, frame);
+                    write_event(file, first, name.c_str(), "e", events[i].timestamp_us, events[i].thread, frame);
+                }
+                write_event(file, first, "frame", "e", events[end - 1].timestamp_us, events[end - 1].thread, frame);
+            }
+            begin = end;
+        }
+        file << "\n]}\n";
+
+        return file ? static_cast<int64_t>(events.size()) : -1;
+    }
+
+    /* to_string */
+    const char* to_string(stage s)
+    {
+        switch (s) {
+            case stage::camera:
+                return "camera";
+            case stage::submitted:
+                return "submitted";
+            case stage::push_frame:
+                return "push_frame";
+            case stage::draw_begin:
+                return "draw_begin";
+            case stage::draw_end:
+                return "draw_end";
+            case stage::texture_ready:
+                return "texture_ready";
+            case stage::presented:
+                return "presented";
+            case stage::count:
+                break;
+        }
+        return "unknown";
+    }
+
+} /* namespace bnb::trace */
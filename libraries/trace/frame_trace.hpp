@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Per-frame latency tracing. Each frame gets an id when it enters the pipeline and every stage
+// it passes records a timestamp into a fixed-size lock-free ring, so recording never blocks and
+// never allocates. The ring keeps the most recent events and is dumped in the Chrome trace
+// event format on demand, to be opened in chrome://tracing or https://ui.perfetto.dev.
+namespace bnb::trace
+{
+
+    // Stages in the order a camera frame passes them
+    enum class stage : uint8_t
+    {
+        camera,        /* the frame is received from the camera or read from a file */
+        submitted,     /* the frame is passed to offscreen_effect_player::process_image_async */
+        push_frame,    /* effect_player::push_frame */
+        draw_begin,    /* effect_player::draw started with the frame as the latest pushed one */
+        draw_end,      /* effect_player::draw returned */
+        texture_ready, /* the image_processing_result::get_texture callback */
+        presented,     /* the frame is passed to glfwSwapBuffers */
+        count
+    };
+
+    // Zero is never returned, it means an untraced frame
+    using frame_id = uint64_t;
+    constexpr frame_id no_frame = 0;
+
+    // Returns a new frame id
+    frame_id begin_frame();
+
+    // Records the stage of the frame. Does nothing for no_frame or when tracing is disabled.
+    void record(frame_id frame, stage s);
+
+    // Associates the frame with an object it travels inside of, usually its pixel buffer, so
+    // a later stage that only receives the object can find the id. Pointers reused for a newer
+    // frame (e.g. pooled buffers) resolve to the newest frame.
+    void tag(const void* object, frame_id frame);
+
+    // Returns no_frame if the object was not tagged recently
+    frame_id find(const void* object);
+
+    void set_enabled(bool enabled);
+
+    bool is_enabled();
+
+    // Writes events currently held in the ring into a Chrome trace event JSON file. Recording
+    // may continue meanwhile, events overwritten during the dump are skipped. Returns the
+    // number of written events, or -1 if the file cannot be created.
+    int64_t dump_chrome_json(const std::string& path);
+
+    const char* to_string(stage s);
+
+} /* namespace bnb::trace */
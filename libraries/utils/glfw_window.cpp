@@ -2,8 +2,26 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <mutex>
+
 using namespace bnb::gl;
 
+namespace
+{
+    // glfwTerminate() destroys all windows, so GLFW is terminated with the last glfw_window
+    std::mutex glfw_users_mutex;
+    int32_t glfw_users = 0;
+
+    void release_glfw()
+    {
+        std::lock_guard<std::mutex> lock(glfw_users_mutex);
+        if (--glfw_users == 0) {
+            glfwTerminate();
+        }
+    }
+} // namespace
+
 glfw_window::glfw_window(const std::string& title, GLFWwindow* share)
 {
     init();
@@ -18,7 +36,10 @@ glfw_window::glfw_window(const std::string& title, GLFWwindow* share)
 
         glfwMakeContextCurrent(nullptr);
     } catch (...) {
-        glfwTerminate();
+        if (m_window != nullptr) {
+            glfwDestroyWindow(m_window);
+        }
+        release_glfw();
         throw;
     }
 }
@@ -27,18 +48,29 @@ glfw_window::~glfw_window()
 {
     glfwMakeContextCurrent(nullptr);
     glfwDestroyWindow(m_window);
-    glfwTerminate();
+    release_glfw();
 }
 
-void glfw_window::set_resize_callback(std::function<void(int32_t w, int32_t h, int32_t w_glfw_buffer, int32_t h_glfw_buffer)> surface_changed)
+void glfw_window::set_resize_callback(resize_cb surface_changed)
 {
     surface_changed_callback = surface_changed;
 }
 
+void glfw_window::set_settled_resize_callback(resize_cb surface_settled, std::chrono::milliseconds quiet_interval)
+{
+    surface_settled_callback = surface_settled;
+    m_resize_debouncer.emplace(quiet_interval);
+}
+
+resize_debouncer::statistics glfw_window::get_resize_statistics() const
+{
+    return m_resize_debouncer ? m_resize_debouncer->get_statistics() : resize_debouncer::statistics {};
+}
+
 void glfw_window::show(uint32_t width_hint, uint32_t height_hint)
 {
-    window_width = width_hint;
-    window_height = height_hint;
+    m_window_width = static_cast<int32_t>(width_hint);
+    m_window_height = static_cast<int32_t>(height_hint);
 
     async::spawn(
         m_scheduler,
@@ -55,23 +87,89 @@ void glfw_window::show(uint32_t width_hint, uint32_t height_hint)
 void glfw_window::run_main_loop()
 {
     while (!glfwWindowShouldClose(m_window)) {
-        glfwWaitEvents();
-        m_scheduler.run_all_tasks();
+        wait_events(get_resize_deadline());
+        process_events();
+    }
+}
+
+void glfw_window::run_main_loop(const std::vector<std::shared_ptr<glfw_window>>& windows)
+{
+    auto is_open = [](const std::shared_ptr<glfw_window>& w) { return !glfwWindowShouldClose(w->m_window); };
+    while (std::any_of(windows.begin(), windows.end(), is_open)) {
+        // Events of all windows are handled here, the callbacks update the state of their window
+        std::optional<resize_debouncer::clock::time_point> deadline;
+        for (const auto& w : windows) {
+            if (auto d = w->get_resize_deadline(); d && (!deadline || *d < *deadline)) {
+                deadline = d;
+            }
+        }
+        wait_events(deadline);
+        for (const auto& w : windows) {
+            if (is_open(w)) {
+                w->process_events();
+            } else if (glfwGetWindowAttrib(w->m_window, GLFW_VISIBLE)) {
+                glfwHideWindow(w->m_window);
+            }
+        }
+    }
+}
+
+glfw_window* glfw_window::from_glfw_window(GLFWwindow* window)
+{
+    return static_cast<glfw_window*>(glfwGetWindowUserPointer(window));
+}
+
+void glfw_window::process_events()
+{
+    m_scheduler.run_all_tasks();
+
+    if ((surface_changed_callback || surface_settled_callback) && m_resized.exchange(false)) {
+        resize_debouncer::size size {m_window_width, m_window_height};
+        glfwGetFramebufferSize(m_window, &size.buffer_width, &size.buffer_height);
+        if (!(size == m_delivered_size)) {
+            m_delivered_size = size;
+            if (surface_changed_callback) {
+                surface_changed_callback(size.width, size.height, size.buffer_width, size.buffer_height);
+            }
+            if (m_resize_debouncer) {
+                m_resize_debouncer->push(size);
+            }
+        }
+    }
 
-        if (surface_changed_callback && resized) {
-            int32_t buffer_width, buffer_height;
-            glfwGetFramebufferSize(m_window, &buffer_width, &buffer_height);
-            surface_changed_callback(window_width, window_height, buffer_width, buffer_height);
-            resized = false;
+    if (m_resize_debouncer && surface_settled_callback) {
+        if (auto size = m_resize_debouncer->poll()) {
+            surface_settled_callback(size->width, size->height, size->buffer_width, size->buffer_height);
         }
     }
 }
 
+void glfw_window::wait_events(std::optional<resize_debouncer::clock::time_point> deadline)
+{
+    if (!deadline) {
+        glfwWaitEvents();
+        return;
+    }
+    auto timeout = std::chrono::duration<double>(*deadline - resize_debouncer::clock::now()).count();
+    if (timeout > 0.0) {
+        glfwWaitEventsTimeout(timeout);
+    } else {
+        glfwPollEvents();
+    }
+}
+
+std::optional<resize_debouncer::clock::time_point> glfw_window::get_resize_deadline() const
+{
+    return m_resize_debouncer ? m_resize_debouncer->get_deadline() : std::nullopt;
+}
+
 void glfw_window::init()
 {
-    if (GLFW_TRUE != glfwInit()) {
+    std::lock_guard<std::mutex> lock(glfw_users_mutex);
+    if (glfw_users == 0 && GLFW_TRUE != glfwInit()) {
         throw std::runtime_error("glfwInit error");
     }
+    ++glfw_users;
 }
 
 void glfw_window::create_window(const std::string& title, GLFWwindow* share)
@@ -118,11 +216,21 @@ void glfw_window::create_window(const std::string& title, GLFWwindow* share)
         throw std::runtime_error("glfwCreateWindow error");
     }
 
-    glfwSetWindowSizeCallback(m_window, [](GLFWwindow*, int w, int h) {
-        glViewport(0, 0, w, h);
-        window_width = w;
-        window_height = h;
-        resized = true;
+    glfwSetWindowUserPointer(m_window, this);
+    // The callbacks run inside glfwWaitEvents() without a current context, the viewport is
+    // set by whoever renders to the window after the resize callback
+    glfwSetWindowSizeCallback(m_window, [](GLFWwindow* window, int w, int h) {
+        if (auto self = from_glfw_window(window)) {
+            self->m_window_width = w;
+            self->m_window_height = h;
+            self->m_resized = true;
+        }
+    });
+    // The framebuffer alone changes e.g. when the window is moved to a screen with another scale
+    glfwSetFramebufferSizeCallback(m_window, [](GLFWwindow* window, int, int) {
+        if (auto self = from_glfw_window(window)) {
+            self->m_resized = true;
+        }
     });
 }
 
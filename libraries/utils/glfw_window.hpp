@@ -3,28 +3,72 @@
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 #include <async++.h>
 
+#include "resize_debouncer.hpp"
+
 namespace bnb::gl
 {
+    // The state of every window is its own, found by the GLFW callbacks through the window user
+    // pointer, so several windows may live in one process. Applications keep their data with
+    // set_user_data() instead of glfwSetWindowUserPointer().
     class glfw_window
     {
     public:
         explicit glfw_window(const std::string& title, GLFWwindow* share = nullptr);
         ~glfw_window();
 
-        void set_resize_callback(std::function<void(int32_t w, int32_t h, int32_t w_glfw_buffer, int32_t h_glfw_buffer)> surface_changed);
+        using resize_cb = std::function<void(int32_t w, int32_t h, int32_t w_glfw_buffer, int32_t h_glfw_buffer)>;
+
+        // Called on every size change, at most once per loop iteration
+        void set_resize_callback(resize_cb surface_changed);
+
+        // Called with the last size of a burst of resizes once the window has not been resized for
+        // the quiet interval, for consumers that reallocate framebuffers on a size change
+        void set_settled_resize_callback(resize_cb surface_settled, std::chrono::milliseconds quiet_interval = std::chrono::milliseconds(200));
+
+        // Resizes passed to the settled resize callback and the ones coalesced away
+        [[nodiscard]] resize_debouncer::statistics get_resize_statistics() const;
 
         void show(uint32_t width_hint, uint32_t height_hint);
         void run_main_loop();
 
+        // Runs the main loop for several windows until all of them are closed, closed windows are hidden
+        static void run_main_loop(const std::vector<std::shared_ptr<glfw_window>>& windows);
+
+        void set_user_data(void* user_data)
+        {
+            m_user_data = user_data;
+        }
+
+        [[nodiscard]] void* get_user_data() const
+        {
+            return m_user_data;
+        }
+
+        // The glfw_window of a GLFW window, e.g. in GLFW callbacks
+        static glfw_window* from_glfw_window(GLFWwindow* window);
+
         [[nodiscard]] GLFWwindow* get_window() const
         {
             return m_window;
         }
 
     private:
+        // Runs the scheduled tasks and passes the latest size to the resize callback, if it has changed
+        void process_events();
+
+        // Waits for events of any window, or until the earliest settled resize is due
+        static void wait_events(std::optional<resize_debouncer::clock::time_point> deadline);
+
+        [[nodiscard]] std::optional<resize_debouncer::clock::time_point> get_resize_deadline() const;
+
         void init();
         void create_window(const std::string& title, GLFWwindow* share = nullptr);
         void load_glad_functions();
@@ -33,11 +77,16 @@ namespace bnb::gl
         async::fifo_scheduler m_scheduler;
         GLFWwindow* m_window{};
 
-        std::function<void(int32_t w, int32_t h, int32_t w_glfw_buffer, int32_t h_glfw_buffer)> surface_changed_callback;
-
-        inline static int32_t window_width = 1;
-        inline static int32_t window_height = 1;
+        resize_cb surface_changed_callback;
+        resize_cb surface_settled_callback;
+        std::optional<resize_debouncer> m_resize_debouncer;
+        void* m_user_data {nullptr};
 
-        inline static bool resized = false;
+        // Written by the GLFW size callbacks, all resizes between two loop iterations are delivered
+        // to the callback once, and only if the size differs from the one delivered before
+        std::atomic<int32_t> m_window_width {1};
+        std::atomic<int32_t> m_window_height {1};
+        std::atomic_bool m_resized {false};
+        resize_debouncer::size m_delivered_size;
     };
 } // namespace bnb::gl
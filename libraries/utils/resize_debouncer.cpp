@@ -0,0 +1,44 @@
+#include "resize_debouncer.hpp"
+
+using namespace bnb::gl;
+
+resize_debouncer::resize_debouncer(std::chrono::milliseconds quiet_interval)
+    : m_quiet_interval(quiet_interval)
+{
+}
+
+void resize_debouncer::push(const size& new_size, clock::time_point now)
+{
+    ++m_statistics.resizes;
+    ++m_pending_resizes;
+    m_pending = new_size;
+    m_last_resize = now;
+}
+
+std::optional<resize_debouncer::size> resize_debouncer::poll(clock::time_point now)
+{
+    if (!m_pending || now - m_last_resize < m_quiet_interval) {
+        return std::nullopt;
+    }
+
+    auto settled = *m_pending;
+    m_pending.reset();
+    if (m_applied == settled) {
+        m_statistics.avoided += m_pending_resizes;
+        m_pending_resizes = 0;
+        return std::nullopt;
+    }
+    m_statistics.avoided += m_pending_resizes - 1;
+    ++m_statistics.applied;
+    m_pending_resizes = 0;
+    m_applied = settled;
+    return settled;
+}
+
+std::optional<resize_debouncer::clock::time_point> resize_debouncer::get_deadline() const
+{
+    if (!m_pending) {
+        return std::nullopt;
+    }
+    return m_last_resize + m_quiet_interval;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace bnb::gl
+{
+    // Coalesces a burst of resizes, e.g. while the window edge is dragged, into the last size,
+    // passed on once no resize has come for the quiet interval. Consumers reallocating their
+    // framebuffers on a size change do it once per burst instead of once per event.
+    class resize_debouncer
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        struct size
+        {
+            int32_t width {0};
+            int32_t height {0};
+            int32_t buffer_width {0};
+            int32_t buffer_height {0};
+
+            bool operator==(const size& other) const
+            {
+                return width == other.width && height == other.height && buffer_width == other.buffer_width && buffer_height == other.buffer_height;
+            }
+        };
+
+        struct statistics
+        {
+            uint64_t resizes {0};
+            uint64_t applied {0};
+            // Resizes replaced by a later one or ending at the applied size
+            uint64_t avoided {0};
+        };
+
+        explicit resize_debouncer(std::chrono::milliseconds quiet_interval);
+
+        void push(const size& new_size, clock::time_point now = clock::now());
+
+        // The last pushed size once the quiet interval has passed, if it differs from the applied one
+        std::optional<size> poll(clock::time_point now = clock::now());
+
+        // When poll() may return the pending size, none if nothing is pending
+        [[nodiscard]] std::optional<clock::time_point> get_deadline() const;
+
+        [[nodiscard]] statistics get_statistics() const
+        {
+            return m_statistics;
+        }
+
+    private:
+        const std::chrono::milliseconds m_quiet_interval;
+        std::optional<size> m_pending;
+        std::optional<size> m_applied;
+        clock::time_point m_last_resize;
+        uint64_t m_pending_resizes {0};
+        statistics m_statistics;
+    };
+} // namespace bnb::gl
@@ -1,11 +1,21 @@
 #include <interfaces/offscreen_effect_player.hpp>
 
 #include "render_context.hpp"
-#include "effect_player.hpp"
-#include "camera_utils.hpp"
-#include "glfw_user_data.hpp"
+#include "offline_processing.hpp"
+#include "frame_throttler.hpp"
+#include "libraries/trace/frame_trace.hpp"
 
-#include <bnb/effect_player/utility.hpp>
+#if !BNB_STUB_EFFECT_PLAYER
+    #include "effect_player.hpp"
+    #include "camera_utils.hpp"
+    #include "glfw_user_data.hpp"
+
+    #include <bnb/effect_player/utility.hpp>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
 
 #if defined(__APPLE__)
 #include <mach-o/dyld.h>
@@ -14,14 +24,41 @@
 
 #define BNB_CLIENT_TOKEN <#Place your token here#>
 
-int main()
+int main(int argc, char** argv)
 {
     // Frame size
-    constexpr int32_t oep_width = 1280;
-    constexpr int32_t oep_height = 720;
+    int32_t oep_width = 1280;
+    int32_t oep_height = 720;
+
+    // Camera frames submitted to the OEP and not yet rendered. One frame gives the lowest latency,
+    // more frames let the camera thread and the OEP work in parallel when the effect is heavy.
+    constexpr int32_t max_frames_in_flight = 2;
+    // What happens to camera frames arriving while all of them are in flight
+    constexpr auto drop_policy = bnb::frame_drop_policy::drop_oldest;
+
+    // With arguments the example processes a file instead of the camera stream, see offline_processor::print_usage
+    std::optional<bnb::offline_processing_options> offline_options;
+    std::unique_ptr<bnb::offline_processor> offline_processor;
+    if (argc > 1) {
+        offline_options = bnb::offline_processor::parse_arguments(argc, argv);
+        if (!offline_options) {
+            bnb::offline_processor::print_usage(argv[0]);
+            return 1;
+        }
+        try {
+            offline_processor = std::make_unique<bnb::offline_processor>(*offline_options);
+        } catch (const std::exception& e) {
+            std::cout << "[ERROR] " << e.what() << std::endl;
+            return 1;
+        }
+        // Files are processed in their own resolution
+        oep_width = offline_processor->get_width();
+        oep_height = offline_processor->get_height();
+    }
 
     std::shared_ptr<bnb::gl::glfw_window> window = nullptr; // Should be declared here to destroy in the last turn
                                                
+#if !BNB_STUB_EFFECT_PLAYER
     // Create an instance of effect_player implementation with cpp api, pass path to location of
     // effects and client token
     std::vector<std::string> dirs;
@@ -43,8 +80,22 @@ int main()
     // The usage of this class is necessary in order to properly initialize and deinitialize Banuba SDK
     bnb::utility m_utility(dirs, BNB_CLIENT_TOKEN);
 
+    // Effects listed in BNB_PRELOAD_EFFECTS are switched with the number keys in the preview,
+    // their files are read ahead in the background so switching does not wait for the disk
+    auto preload_effects = bnb::effect_preloader::effects_from_environment();
+    auto preloader = std::make_shared<bnb::effect_preloader>(dirs);
+    preloader->preload(preload_effects);
+#endif
+
+    if (offline_processor && offline_options->streams > 1) {
+        // Every stream creates its own OEP stack, see stream_manager
+        offline_processor->run_streams();
+        return 0;
+    }
+
     // Create instance of render_context.
     // NOTE: each instance of Offscreen Render Target should have its own instance of Render Context
+    // (many OEPs may time-share a few GL contexts through render contexts of bnb::oep::render_context_pool)
     auto rc = bnb::oep::interfaces::render_context::create();
 
     // Create an instance of our offscreen_render_target implementation, you can use your own.
@@ -54,12 +105,35 @@ int main()
 
     // Create our implementation of effect_player, pass effect player frame buffer sizes
     auto ep = bnb::oep::interfaces::effect_player::create(oep_width, oep_height);
+#if !BNB_STUB_EFFECT_PLAYER
+    std::static_pointer_cast<bnb::oep::effect_player>(ep)->set_effect_preloader(preloader);
+#endif
 
     // Create instance of offscreen_effect_player, pass effect_player, offscreen_render_target
     // and dimensions of the processing frame (for the best performance it is better that they will coincide
     // with camera frame dimensions)
     auto oep = bnb::oep::interfaces::offscreen_effect_player::create(ep, ort, oep_width, oep_height);
 
+    if (offline_processor) {
+        if (!offline_options->effect.empty()) {
+            oep->load_effect(offline_options->effect);
+        }
+        offline_processor->run(oep);
+        return 0;
+    }
+
+#if BNB_STUB_EFFECT_PLAYER
+    // The camera is a part of the Banuba SDK
+    std::cout << "[ERROR] The camera preview requires the Banuba SDK, only file processing is available" << std::endl;
+    bnb::offline_processor::print_usage(argv[0]);
+    return 1;
+#elif BNB_HEADLESS_RENDER_CONTEXT
+    // The preview window shares resources with the GLFW based render context, so it cannot be used with EGL
+    std::cout << "[ERROR] The preview window requires the GLFW render context, only file processing is available" << std::endl;
+    bnb::offline_processor::print_usage(argv[0]);
+    return 1;
+#else
+
     // Make glfw_window and render_thread only for show result of OEP
     // We want to share resources between context, we know that render_context is based on
     // GLFW and returned context is GLFWwindow
@@ -68,48 +142,93 @@ int main()
 
     oep->load_effect(<#Place the effect name here, e.g. effects/test_BG#>);
 
-    // Callback for received frame from the camera
-    auto camera_callback = [weak_oep = std::weak_ptr<decltype(oep)::element_type>(oep),
-        weak_render_t = std::weak_ptr<decltype(render_t)::element_type>(render_t)](bnb::full_image_t image) {
+    // Size of the OEP result textures, the size last passed to oep->surface_changed. The width is in
+    // the high and the height in the low 32 bits, so a frame never takes the width of one size and
+    // the height of another.
+    auto pack_size = [](int32_t width, int32_t height) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(width)) << 32) | static_cast<uint32_t>(height);
+    };
+    auto oep_surface_size = std::make_shared<std::atomic<uint64_t>>(pack_size(oep_width, oep_height));
+
+    // Passes camera frames to the OEP, at most max_frames_in_flight at a time
+    auto throttler = bnb::frame_throttler::create(max_frames_in_flight, drop_policy, [weak_oep = std::weak_ptr<decltype(oep)::element_type>(oep),
+        weak_render_t = std::weak_ptr<decltype(render_t)::element_type>(render_t), oep_surface_size](pixel_buffer_sptr pb_image, bnb::frame_throttler::frame_done_cb done) {
         auto oep = weak_oep.lock();
         auto render_t = weak_render_t.lock();
         if (!oep || !render_t) {
+            done();
             return;
         }
+        auto trace_frame = bnb::trace::find(pb_image.get());
+        bnb::trace::record(trace_frame, bnb::trace::stage::submitted);
+        // The paced present mode keeps the intervals the frames were submitted at
+        auto timestamp = std::chrono::steady_clock::now();
+        // The OEP renders the frame in the size it has when the frame is submitted. Around a resize
+        // a frame may get the next size a moment early, it is then fitted slightly off once.
+        auto surface_size = oep_surface_size->load();
+        auto texture_width = static_cast<int32_t>(surface_size >> 32);
+        auto texture_height = static_cast<int32_t>(surface_size & 0xffffffff);
         // Callback for received pixel buffer from the offscreen effect player
-        auto get_pixel_buffer_callback = [render_t](image_processing_result_sptr result) {
+        auto get_pixel_buffer_callback = [render_t, done, trace_frame, timestamp, texture_width, texture_height](image_processing_result_sptr result) {
             if (result != nullptr) {
-                // Callback for update data in render thread
-                auto render_callback = [render_t](std::optional<rendered_texture_t> texture_id) {
+                // Callback for update data in render thread. It is called with the OEP context current,
+                // so update_texture can fence the texture there for the window's context to wait on
+                auto render_callback = [render_t, trace_frame, timestamp, texture_width, texture_height](std::optional<rendered_texture_t> texture_id) {
+                    bnb::trace::record(trace_frame, bnb::trace::stage::texture_ready);
                     if (texture_id.has_value()) {
                         auto gl_texture = static_cast<GLuint>(reinterpret_cast<int64_t>(*texture_id));
-                        render_t->update_texture(gl_texture);
+                        render_t->update_texture(gl_texture, texture_width, texture_height, trace_frame, timestamp);
                     }
                 };
                 // Get texture id from shared context and render it
                 result->get_texture(render_callback);
             }
+            // The frame is rendered (or lost), the next one may be submitted
+            done();
         };
-
-        // Convert bnb full_image_t to OEP pixel_buffer
-        // This function just wraps data from one type to another, without doing any manipulations with
-        // the data itself, and without copying it
-        auto pb_image = bnb::camera_utils::full_image_to_pixel_buffer(image);
         // Start image processing
         oep->process_image_async(pb_image, bnb::oep::interfaces::rotation::deg0, true, get_pixel_buffer_callback, bnb::oep::interfaces::rotation::deg0);
+    });
+
+    // Camera frames are copied into recycled buffers, so the camera layer gets its image back at once
+    // and no per-frame allocation is made once the pool holds the frames in flight
+    auto camera_pool = bnb::pixel_buffer_pool::create();
+
+    // Callback for received frame from the camera
+    auto camera_callback = [weak_throttler = std::weak_ptr<bnb::frame_throttler>(throttler), camera_pool](bnb::full_image_t image) {
+        auto throttler = weak_throttler.lock();
+        if (!throttler) {
+            return;
+        }
+        auto trace_frame = bnb::trace::begin_frame();
+        bnb::trace::record(trace_frame, bnb::trace::stage::camera);
+        // Convert bnb full_image_t to OEP pixel_buffer taken from the pool
+        auto pb_image = bnb::camera_utils::full_image_to_pixel_buffer(image, camera_pool);
+        if (pb_image == nullptr) {
+            return;
+        }
+        // Later stages only see the pixel buffer, they look the frame id up by it
+        bnb::trace::tag(pb_image.get(), trace_frame);
+        // Submit the frame, or drop it if the OEP is behind the camera
+        throttler->push(pb_image);
     };
     // Create and run instance of camera, pass callback for frames
     auto camera_ptr = bnb::create_camera_device(camera_callback, 0);
 
-    bnb::glfw_user_data ud(oep, render_t, camera_ptr, camera_callback);
+    bnb::glfw_user_data ud(oep, render_t, throttler, camera_ptr, camera_callback, preload_effects);
 
-    glfwSetWindowUserPointer(window->get_window(), &ud);
+    window->set_user_data(&ud);
 
     // Demonstration of key press processing.
     // The method demonstrates how to initiate application close by pressing the escape key and 
     // how to start/stop the camera via camera destruction/construction.
+    // The T key writes the latency trace of the recent frames into oep_trace.json.
+    // The number keys load the effects of BNB_PRELOAD_EFFECTS.
+    // The M key switches how frames are fitted into a window of another aspect ratio.
+    // The V key switches the present mode of the preview.
     auto key_func = [](GLFWwindow* window, int key, int scancode, int action, int mods) {
-        auto ud = static_cast<::bnb::glfw_user_data*>(glfwGetWindowUserPointer(window));
+        auto gl_window = bnb::gl::glfw_window::from_glfw_window(window);
+        auto ud = gl_window ? static_cast<::bnb::glfw_user_data*>(gl_window->get_user_data()) : nullptr;
         if (!ud) {
             return;
         }
@@ -124,10 +243,55 @@ int main()
                 oep->stop();
                 ud->camera_ptr().reset();
             }
+        } else if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+            auto events = bnb::trace::dump_chrome_json("oep_trace.json");
+            if (events < 0) {
+                std::cout << "[ERROR] Unable to write oep_trace.json" << std::endl;
+            } else {
+                std::cout << "[INFO] " << events << " trace events written to oep_trace.json" << std::endl;
+            }
+        } else if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+            if (auto renderer = ud->render_target()) {
+                using bnb::render::fit_mode;
+                auto mode = renderer->get_fit_mode();
+                mode = mode == fit_mode::fit ? fit_mode::fill : (mode == fit_mode::fill ? fit_mode::stretch : fit_mode::fit);
+                renderer->set_fit_mode(mode);
+                std::cout << "[INFO] Fit mode: " << bnb::render::to_string(mode) << std::endl;
+            }
+        } else if (key == GLFW_KEY_V && action == GLFW_PRESS) {
+            if (auto renderer = ud->render_target()) {
+                using bnb::render::present_mode;
+                auto mode = renderer->get_present_mode();
+                switch (mode) {
+                    case present_mode::vsync:
+                        mode = present_mode::immediate;
+                        break;
+                    case present_mode::immediate:
+                        mode = present_mode::adaptive;
+                        break;
+                    case present_mode::adaptive:
+                        mode = present_mode::paced;
+                        break;
+                    case present_mode::paced:
+                        mode = present_mode::vsync;
+                        break;
+                }
+                renderer->set_present_mode(mode);
+                std::cout << "[INFO] Present mode: " << bnb::render::to_string(mode) << std::endl;
+            }
+        } else if (key >= GLFW_KEY_1 && key <= GLFW_KEY_9 && action == GLFW_PRESS) {
+            auto index = static_cast<size_t>(key - GLFW_KEY_1);
+            if (auto oep = ud->oep(); oep && index < ud->effects().size()) {
+                oep->load_effect(ud->effects()[index]);
+            }
         } else if (key == GLFW_KEY_S && action == GLFW_PRESS) {
             if (auto oep = ud->oep()) {
                 // If key pressed when oep unstopped
                 if (ud->camera_ptr().get() == nullptr) {
+                    // The stopped OEP may never return frames submitted before, do not wait for them
+                    if (auto throttler = ud->throttler()) {
+                        throttler->reset();
+                    }
                     ud->camera_ptr() = bnb::create_camera_device(ud->push_frame_cb(), 0);
                     oep->resume();
                 }
@@ -140,7 +304,7 @@ int main()
         if (!window) {
             return;
         }
-        auto ud = static_cast<::bnb::glfw_user_data*>(glfwGetWindowUserPointer(window->get_window()));
+        auto ud = static_cast<::bnb::glfw_user_data*>(window->get_user_data());
         if (!ud) {
             return;
         }
@@ -149,16 +313,78 @@ int main()
         if (w <= 0 || h <= 0 || w_glfw_buffer <= 0 || h_glfw_buffer <= 0) {
             return;
         }
+        // The viewport follows the window at once, the previous frames are letterboxed in it
         if (auto render_t = ud->render_target(); render_t.get()) {
             render_t->surface_changed(w_glfw_buffer, h_glfw_buffer);
         }
+    });
+    // The OEP reallocates its framebuffers on every surface change, so it gets only the size
+    // the window has settled at, not every step of dragging its edge
+    window->set_settled_resize_callback([weak_window = std::weak_ptr<decltype(window)::element_type>(window), oep_surface_size, pack_size](int32_t w, int32_t h, int32_t w_glfw_buffer, int32_t h_glfw_buffer) {
+        auto window = weak_window.lock();
+        if (!window) {
+            return;
+        }
+        auto ud = static_cast<::bnb::glfw_user_data*>(window->get_user_data());
+        if (!ud) {
+            return;
+        }
+
+        if (w <= 0 || h <= 0 || w_glfw_buffer <= 0 || h_glfw_buffer <= 0) {
+            return;
+        }
         if (auto oep = ud->oep(); oep.get()) {
             oep->surface_changed(w, h);
+            oep_surface_size->store(pack_size(w, h));
         }
     });
     render_t->start_auto_rendering(window->get_window());
     window->show(oep_width, oep_height);
     window->run_main_loop();
 
+    auto stats = throttler->get_statistics();
+    std::cout << "[INFO] Camera frames: " << stats.frames_pushed << " received, " << stats.frames_submitted << " processed, "
+              << stats.frames_dropped << " dropped (" << bnb::to_string(drop_policy) << ", " << max_frames_in_flight
+              << " in flight, " << stats.max_frames_in_flight_seen << " at most)" << std::endl;
+    auto pool_stats = camera_pool->get_statistics();
+    std::cout << "[INFO] Camera frame buffers: " << pool_stats.buffers_allocated << " allocated, " << pool_stats.hits << " reused, "
+              << pool_stats.high_water_mark << " in use at most" << std::endl;
+    auto pacing = render_t->get_pacing_statistics();
+    std::cout << "[INFO] Presented frames: " << pacing.intervals << " intervals of " << pacing.average_interval_ms << " ms on average, "
+              << pacing.interval_stddev_ms << " ms deviation, " << pacing.average_latency_ms << " ms latency on average, "
+              << pacing.max_latency_ms << " ms at most" << std::endl;
+    std::cout << "[INFO] Present intervals (ms: frames):";
+    for (size_t i = 0; i < pacing.interval_histogram.size(); ++i) {
+        if (pacing.interval_histogram[i] > 0) {
+            std::cout << " " << i << (i + 1 == pacing.interval_histogram.size() ? "+" : "") << ": " << pacing.interval_histogram[i];
+        }
+    }
+    std::cout << std::endl;
+    if (render_t->get_gl_calls_count() > 0 && render_t->get_presented_frames_count() > 0) {
+        std::cout << "[INFO] GL calls per presented frame: "
+                  << static_cast<double>(render_t->get_gl_calls_count()) / render_t->get_presented_frames_count() << std::endl;
+    }
+    auto resize_stats = window->get_resize_statistics();
+    std::cout << "[INFO] Window resizes: " << resize_stats.resizes << ", " << resize_stats.applied << " passed to the OEP, "
+              << resize_stats.avoided << " framebuffer reallocations avoided" << std::endl;
+    auto js_stats = std::static_pointer_cast<bnb::oep::effect_player>(ep)->get_js_statistics();
+    if (js_stats.calls > 0) {
+        std::cout << "[INFO] JS calls: " << js_stats.calls << " made, " << js_stats.coalesced_calls << " coalesced, "
+                  << js_stats.evaluations << " evaluations, " << js_stats.max_queue_depth << " queued at most, "
+                  << js_stats.average_js_ms << " ms per frame on average" << std::endl;
+    }
+    auto scale_stats = std::static_pointer_cast<bnb::oep::effect_player>(ep)->get_scale_statistics();
+    if (scale_stats.frame_budget_ms > 0.0) {
+        std::cout << "[INFO] Effect scale: " << scale_stats.scale << " (" << scale_stats.min_scale_seen << " at least), "
+                  << scale_stats.downscales << " downscales, " << scale_stats.upscales << " upscales, last change at "
+                  << scale_stats.last_change_draw_ms << " ms draw time, budget " << scale_stats.frame_budget_ms << " ms" << std::endl;
+    }
+    for (const auto& [effect, load_stats] : preloader->get_statistics()) {
+        std::cout << "[INFO] Effect " << effect << ": " << load_stats.loads << " loads (" << load_stats.warm_loads << " warm), "
+                  << load_stats.average_load_ms << " ms on average, " << load_stats.max_load_ms << " ms at most, files of "
+                  << load_stats.bytes << " bytes preloaded in " << load_stats.preload_ms << " ms" << std::endl;
+    }
+
     return 0;
+#endif
 }
@@ -0,0 +1,460 @@
+#include "offline_processing.hpp"
+
+#include "stream_manager.hpp"
+#include "render_context_pool.hpp"
+#include "libraries/renderer/texture_readback.hpp"
+#include "libraries/trace/frame_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+
+    using image_format = bnb::oep::interfaces::image_format;
+
+    // If the OEP does not return a frame in this time it is considered lost
+    constexpr std::chrono::seconds result_timeout {10};
+
+    bool is_full_range(image_format format)
+    {
+        switch (format) {
+            case image_format::nv12_bt601_full:
+            case image_format::nv12_bt709_full:
+            case image_format::i420_bt601_full:
+            case image_format::i420_bt709_full:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Y4M output is always I420, the color standard and range follow the input
+    image_format make_output_format(image_format input)
+    {
+        switch (input) {
+            case image_format::nv12_bt601_full:
+                return image_format::i420_bt601_full;
+            case image_format::nv12_bt601_video:
+                return image_format::i420_bt601_video;
+            case image_format::nv12_bt709_full:
+                return image_format::i420_bt709_full;
+            case image_format::nv12_bt709_video:
+                return image_format::i420_bt709_video;
+            default:
+                return input;
+        }
+    }
+
+    bnb::frame_file_reader open_reader(const bnb::offline_processing_options& options)
+    {
+        if (options.raw_packed_layout.has_value()) {
+            return bnb::frame_file_reader(options.input_path, *options.raw_packed_layout, is_full_range(*options.raw_format), options.raw_width, options.raw_height);
+        }
+        if (options.raw_format.has_value()) {
+            return bnb::frame_file_reader(options.input_path, *options.raw_format, options.raw_width, options.raw_height);
+        }
+        return bnb::frame_file_reader(options.input_path);
+    }
+
+    struct processing_state
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        int32_t frames_in_flight {0};
+        int64_t frames_written {0};
+        int64_t frames_failed {0};
+        // Never submitted to a stream, the block policy gave up waiting for it
+        int64_t frames_dropped {0};
+        // The final readback release was submitted to the OEP and has not run yet
+        bool readback_release_pending {false};
+    };
+
+} /* namespace */
+
+namespace bnb
+{
+
+    /* offline_processor::parse_arguments */
+    std::optional<offline_processing_options> offline_processor::parse_arguments(int argc, char** argv)
+    {
+        offline_processing_options options;
+        bool full_range = false;
+        std::string raw_format;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--full-range") {
+                full_range = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cout << "[ERROR] Missing value for " << arg << std::endl;
+                return std::nullopt;
+            }
+            std::string value = argv[++i];
+            if (arg == "--input") {
+                options.input_path = value;
+            } else if (arg == "--output") {
+                options.output_path = value;
+            } else if (arg == "--effect") {
+                options.effect = value;
+            } else if (arg == "--raw-format") {
+                raw_format = value;
+            } else if (arg == "--size") {
+                if (std::sscanf(value.c_str(), "%dx%d", &options.raw_width, &options.raw_height) != 2) {
+                    std::cout << "[ERROR] Invalid frame size " << value << ", expected WIDTHxHEIGHT" << std::endl;
+                    return std::nullopt;
+                }
+            } else if (arg == "--readback") {
+                if (value != "oep" && value != "pbo") {
+                    std::cout << "[ERROR] Unknown readback " << value << ", expected oep or pbo" << std::endl;
+                    return std::nullopt;
+                }
+                options.pbo_readback = value == "pbo";
+            } else if (arg == "--trace") {
+                options.trace_path = value;
+            } else if (arg == "--in-flight") {
+                options.max_frames_in_flight = std::max(1, std::atoi(value.c_str()));
+            } else if (arg == "--streams") {
+                options.streams = std::max(1, std::atoi(value.c_str()));
+            } else if (arg == "--contexts") {
+                options.render_contexts = std::max(0, std::atoi(value.c_str()));
+            } else {
+                std::cout << "[ERROR] Unknown argument " << arg << std::endl;
+                return std::nullopt;
+            }
+        }
+
+        if (options.input_path.empty() || options.output_path.empty()) {
+            std::cout << "[ERROR] Both --input and --output are required" << std::endl;
+            return std::nullopt;
+        }
+
+        if (raw_format == "nv12") {
+            options.raw_format = full_range ? image_format::nv12_bt601_full : image_format::nv12_bt601_video;
+        } else if (raw_format == "i420") {
+            options.raw_format = full_range ? image_format::i420_bt601_full : image_format::i420_bt601_video;
+        } else if (raw_format == "yuy2" || raw_format == "uyvy") {
+            options.raw_format = full_range ? image_format::nv12_bt601_full : image_format::nv12_bt601_video;
+            options.raw_packed_layout = raw_format == "yuy2" ? frame_file_reader::packed_yuv_layout::yuy2 : frame_file_reader::packed_yuv_layout::uyvy;
+        } else if (!raw_format.empty()) {
+            std::cout << "[ERROR] Unknown raw format " << raw_format << ", expected nv12, i420, yuy2 or uyvy" << std::endl;
+            return std::nullopt;
+        }
+        if (options.raw_format.has_value() && (options.raw_width <= 0 || options.raw_height <= 0)) {
+            std::cout << "[ERROR] --size is required for raw input" << std::endl;
+            return std::nullopt;
+        }
+
+        return options;
+    }
+
+    /* offline_processor::print_usage */
+    void offline_processor::print_usage(const char* executable)
+    {
+        std::cout << "Usage: " << executable << " --input <file> --output <file.y4m> [options]\n"
+                  << "  --input <file>                     Y4M file, or raw frames with --raw-format and --size\n"
+                  << "  --output <file.y4m>                processed frames in I420\n"
+                  << "  --effect <name>                    effect to apply, e.g. effects/test_BG\n"
+                  << "  --raw-format <nv12|i420|yuy2|uyvy> input is headerless BT.601 frames of this format\n"
+                  << "  --size <W>x<H>                     frame size of raw input\n"
+                  << "  --full-range                       raw input uses the full color range\n"
+                  << "  --in-flight <N>                    frames submitted before waiting for results (default 2)\n"
+                  << "  --readback <oep|pbo>               read results with get_image (default) or asynchronously from textures\n"
+                  << "  --trace <file.json>                write per-frame stage timestamps in the Chrome trace format\n"
+                  << "  --streams <N>                      process the input by N independent pipelines at once, the first one is written\n"
+                  << "  --contexts <N>                     with --streams, share N GL contexts between the streams instead of one each\n"
+                  << "Without arguments the example processes the camera stream." << std::endl;
+    }
+
+    /* offline_processor::offline_processor */
+    offline_processor::offline_processor(const offline_processing_options& options)
+        : m_options(options)
+        , m_reader(open_reader(options))
+        , m_writer(std::make_shared<y4m_file_writer>(
+              options.output_path,
+              m_reader.get_width(),
+              m_reader.get_height(),
+              m_reader.get_fps_numerator(),
+              m_reader.get_fps_denominator(),
+              is_full_range(m_reader.get_image_format())))
+    {
+    }
+
+    /* offline_processor::run */
+    int64_t offline_processor::run(const offscreen_effect_player_sptr& oep)
+    {
+        // The state is shared with callbacks, which may outlive this call if the OEP loses a frame
+        auto state = std::make_shared<processing_state>();
+        auto writer = m_writer;
+        auto output_format = make_output_format(m_reader.get_image_format());
+
+        auto finish_frame = [state, writer](pixel_buffer_sptr image) {
+            if (image != nullptr) {
+                writer->write_frame(image);
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                --state->frames_in_flight;
+                if (image != nullptr) {
+                    ++state->frames_written;
+                } else {
+                    ++state->frames_failed;
+                }
+            }
+            state->cv.notify_all();
+        };
+
+        // Textures are read back on the OEP thread, the readback is created and released there
+        std::shared_ptr<bnb::render::texture_readback> readback;
+        auto max_frames_in_flight = m_options.max_frames_in_flight;
+        if (m_options.pbo_readback) {
+            readback = std::make_shared<bnb::render::texture_readback>(output_format);
+            // Frames queued in the readback ring are written only when later frames are read
+            // back, so they must not take the slots of those frames
+            max_frames_in_flight += readback->get_ring_size();
+        }
+        auto width = m_reader.get_width();
+        auto height = m_reader.get_height();
+
+        auto start = std::chrono::steady_clock::now();
+        int64_t frames_read = 0;
+
+        // Resubmitted after the others to release the readback on the OEP thread
+        pixel_buffer_sptr last_frame;
+
+        while (auto frame = m_reader.read_frame()) {
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                if (!state->cv.wait_for(lock, result_timeout, [max_frames_in_flight, &state]() { return state->frames_in_flight < max_frames_in_flight; })) {
+                    std::cout << "[ERROR] The OEP stopped returning frames" << std::endl;
+                    break;
+                }
+                ++state->frames_in_flight;
+            }
+            ++frames_read;
+
+            auto trace_frame = bnb::trace::begin_frame();
+            bnb::trace::record(trace_frame, bnb::trace::stage::camera);
+            bnb::trace::tag(frame.get(), trace_frame);
+
+            auto process_callback = [finish_frame, output_format, trace_frame, readback, width, height](image_processing_result_sptr result) {
+                if (result == nullptr) {
+                    finish_frame(nullptr);
+                    return;
+                }
+                if (readback) {
+                    result->get_texture([finish_frame, trace_frame, readback, width, height](std::optional<rendered_texture_t> texture) {
+                        bnb::trace::record(trace_frame, bnb::trace::stage::texture_ready);
+                        if (texture.has_value()) {
+                            readback->read(static_cast<GLuint>(reinterpret_cast<int64_t>(*texture)), width, height, finish_frame);
+                        } else {
+                            finish_frame(nullptr);
+                        }
+                    });
+                    return;
+                }
+                result->get_image(output_format, [finish_frame, trace_frame](std::optional<pixel_buffer_sptr> image) {
+                    bnb::trace::record(trace_frame, bnb::trace::stage::texture_ready);
+                    finish_frame(image.has_value() ? *image : nullptr);
+                });
+            };
+            bnb::trace::record(trace_frame, bnb::trace::stage::submitted);
+            oep->process_image_async(frame, bnb::oep::interfaces::rotation::deg0, false, process_callback, bnb::oep::interfaces::rotation::deg0);
+            last_frame = std::move(frame);
+        }
+
+        if (readback && last_frame != nullptr) {
+            // However the loop ended, the frames queued in the readback ring are delivered and the GL
+            // objects deleted by one more frame. The OEP processes frames in order, so its callback runs
+            // after the callbacks of all frames above, on the OEP thread with the OEP context current.
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->readback_release_pending = true;
+            }
+            auto release_callback = [state, readback](image_processing_result_sptr result) {
+                auto released = [state]() {
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        state->readback_release_pending = false;
+                    }
+                    state->cv.notify_all();
+                };
+                if (result == nullptr) {
+                    std::cout << "[ERROR] The OEP lost the frame releasing the readback" << std::endl;
+                    released();
+                    return;
+                }
+                result->get_texture([readback, released](std::optional<rendered_texture_t>) {
+                    readback->release();
+                    released();
+                });
+            };
+            oep->process_image_async(last_frame, bnb::oep::interfaces::rotation::deg0, false, release_callback, bnb::oep::interfaces::rotation::deg0);
+        }
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (!state->cv.wait_for(lock, result_timeout, [&state]() { return state->frames_in_flight == 0 && !state->readback_release_pending; })) {
+            std::cout << "[ERROR] " << state->frames_in_flight << " frames were not returned by the OEP" << std::endl;
+            if (state->readback_release_pending) {
+                std::cout << "[ERROR] The readback was not released, its GL objects are leaked" << std::endl;
+            }
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        auto fps = elapsed.count() > 0.0 ? static_cast<double>(state->frames_written) / elapsed.count() : 0.0;
+        std::cout << "[INFO] Processed " << state->frames_written << " of " << frames_read << " frames ("
+                  << m_reader.get_width() << "x" << m_reader.get_height() << ") in " << elapsed.count()
+                  << " s, " << fps << " fps";
+        if (state->frames_failed > 0) {
+            std::cout << ", " << state->frames_failed << " failed";
+        }
+        std::cout << std::endl;
+
+        if (readback) {
+            auto readback_statistics = readback->get_statistics();
+            std::cout << "[INFO] Readback: " << readback_statistics.frames_read << " frames, "
+                      << static_cast<double>(readback_statistics.bytes_read) / (1024.0 * 1024.0) / elapsed.count() << " MiB/s, latency "
+                      << readback_statistics.average_latency_ms << " ms average, " << readback_statistics.max_latency_ms << " ms at most, copy "
+                      << readback_statistics.average_copy_ms << " ms, " << readback_statistics.ring_stalls << " ring stalls" << std::endl;
+        }
+
+        auto pool = m_reader.get_pool()->get_statistics();
+        std::cout << "[INFO] Frame pool: " << pool.hits << " hits, " << pool.misses << " misses, "
+                  << pool.high_water_mark << " buffers at most in use" << std::endl;
+
+        if (!m_options.trace_path.empty()) {
+            if (bnb::trace::dump_chrome_json(m_options.trace_path) < 0) {
+                std::cout << "[ERROR] Unable to write " << m_options.trace_path << std::endl;
+            }
+        }
+
+        return state->frames_written;
+    }
+
+    /* offline_processor::run_streams */
+    int64_t offline_processor::run_streams()
+    {
+        auto state = std::make_shared<processing_state>();
+        auto writer = m_writer;
+        auto output_format = make_output_format(m_reader.get_image_format());
+
+        // Results of every stream are read back, so each stream does the same work as the written one
+        auto finish_frame = [state, writer](pixel_buffer_sptr image, bool write) {
+            if (image != nullptr && write) {
+                writer->write_frame(image);
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                --state->frames_in_flight;
+                if (image != nullptr && write) {
+                    ++state->frames_written;
+                } else if (image == nullptr) {
+                    ++state->frames_failed;
+                }
+            }
+            state->cv.notify_all();
+        };
+
+        bnb::oep::render_context_pool_sptr pool;
+        stream_manager::render_context_factory render_context_factory;
+        if (m_options.render_contexts > 0) {
+            pool = bnb::oep::render_context_pool::create(m_options.render_contexts);
+            render_context_factory = [pool](stream_id id) { return pool->acquire(id); };
+        }
+
+        stream_manager manager(render_context_factory);
+        stream_config config;
+        config.width = m_reader.get_width();
+        config.height = m_reader.get_height();
+        config.effect = m_options.effect;
+        config.max_frames_in_flight = m_options.max_frames_in_flight;
+        // No frame of a file may be dropped, however long the first effect load or a shared context takes
+        config.drop_policy = frame_drop_policy::block;
+        config.block_timeout = frame_throttler::no_block_timeout;
+
+        std::vector<stream_id> streams;
+        for (int32_t i = 0; i < m_options.streams; ++i) {
+            auto written_stream = streams.empty();
+            streams.push_back(manager.add_stream(config, [finish_frame, output_format, written_stream](stream_id, image_processing_result_sptr result) {
+                if (result == nullptr) {
+                    finish_frame(nullptr, written_stream);
+                    return;
+                }
+                result->get_image(output_format, [finish_frame, written_stream](std::optional<pixel_buffer_sptr> image) {
+                    finish_frame(image.has_value() ? *image : nullptr, written_stream);
+                });
+            }));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int64_t frames_read = 0;
+
+        while (auto frame = m_reader.read_frame()) {
+            ++frames_read;
+            auto trace_frame = bnb::trace::begin_frame();
+            bnb::trace::record(trace_frame, bnb::trace::stage::camera);
+            bnb::trace::tag(frame.get(), trace_frame);
+
+            for (auto id : streams) {
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    ++state->frames_in_flight;
+                }
+                // Waits while the stream has max_frames_in_flight frames in flight
+                if (!manager.push_frame(id, frame)) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    --state->frames_in_flight;
+                    ++state->frames_dropped;
+                }
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if (!state->cv.wait_for(lock, result_timeout, [&state]() { return state->frames_in_flight == 0; })) {
+                std::cout << "[ERROR] " << state->frames_in_flight << " frames were not returned by the OEP" << std::endl;
+            }
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        auto total_frames = static_cast<double>(frames_read) * static_cast<double>(streams.size()) - static_cast<double>(state->frames_dropped);
+        std::cout << "[INFO] Processed " << frames_read << " frames (" << m_reader.get_width() << "x" << m_reader.get_height()
+                  << ") by " << streams.size() << " streams in " << elapsed.count() << " s, "
+                  << (elapsed.count() > 0.0 ? total_frames / elapsed.count() : 0.0) << " fps in total";
+        if (state->frames_failed > 0) {
+            std::cout << ", " << state->frames_failed << " failed";
+        }
+        if (state->frames_dropped > 0) {
+            std::cout << ", " << state->frames_dropped << " dropped";
+        }
+        std::cout << std::endl;
+
+        for (const auto& stream : manager.get_statistics()) {
+            std::cout << "[INFO] Stream " << stream.id << ": " << stream.frames_processed << " frames, " << stream.fps << " fps, latency "
+                      << stream.average_latency_ms << " ms average, " << stream.max_latency_ms << " ms at most" << std::endl;
+        }
+
+        if (pool) {
+            auto contexts = pool->get_statistics();
+            std::cout << "[INFO] Render contexts: " << pool->get_contexts_count() << " shared, " << contexts.activations << " activations, "
+                      << contexts.context_switches << " switches, " << contexts.contended_activations << " waited for another stream, "
+                      << contexts.state_resets << " GL state resets" << std::endl;
+        }
+
+        if (!m_options.trace_path.empty()) {
+            if (bnb::trace::dump_chrome_json(m_options.trace_path) < 0) {
+                std::cout << "[ERROR] Unable to write " << m_options.trace_path << std::endl;
+            }
+        }
+
+        return state->frames_written;
+    }
+
+} /* namespace bnb */
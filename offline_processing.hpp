@@ -0,0 +1,77 @@
+#pragma once
+
+#include <interfaces/offscreen_effect_player.hpp>
+
+#include "frame_file.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace bnb
+{
+
+    struct offline_processing_options
+    {
+        std::string input_path;
+        std::string output_path;
+        std::string effect;
+
+        // Only for raw input files, Y4M files describe themselves in the header
+        std::optional<bnb::oep::interfaces::image_format> raw_format;
+        // Set for packed 4:2:2 input, raw_format is then the NV12 format frames are converted into
+        std::optional<frame_file_reader::packed_yuv_layout> raw_packed_layout;
+        int32_t raw_width {0};
+        int32_t raw_height {0};
+
+        // How many frames are submitted to the OEP before waiting for the oldest result
+        int32_t max_frames_in_flight {2};
+
+        // Read results back as textures through a ring of pixel pack buffers instead of get_image
+        bool pbo_readback {false};
+
+        // Chrome trace event JSON with per-frame stage timestamps, written when processing ends
+        std::string trace_path;
+
+        // Independent OEP pipelines the input is processed by at once, only the first one is written
+        int32_t streams {1};
+        // GL contexts shared by the streams, 0 for a context per stream
+        int32_t render_contexts {0};
+    };
+
+    // Feeds frames from a file through the OEP as fast as it processes them and writes
+    // the results into a Y4M file, so effects can be checked without a camera or a screen
+    class offline_processor
+    {
+    public:
+        // Returns std::nullopt and prints the reason when arguments are missing or invalid
+        static std::optional<offline_processing_options> parse_arguments(int argc, char** argv);
+
+        static void print_usage(const char* executable);
+
+        explicit offline_processor(const offline_processing_options& options);
+
+        // Processes the whole input file and prints the throughput, returns the number of written frames
+        int64_t run(const offscreen_effect_player_sptr& oep);
+
+        // Processes the input file by options.streams pipelines of a stream_manager at once and prints
+        // the throughput of each, returns the number of frames written by the first one
+        int64_t run_streams();
+
+        [[nodiscard]] int32_t get_width() const
+        {
+            return m_reader.get_width();
+        }
+
+        [[nodiscard]] int32_t get_height() const
+        {
+            return m_reader.get_height();
+        }
+
+    private:
+        offline_processing_options m_options;
+        frame_file_reader m_reader;
+        std::shared_ptr<y4m_file_writer> m_writer;
+    }; /* class offline_processor */
+
+} /* namespace bnb */
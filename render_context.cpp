@@ -1,6 +1,8 @@
 #include "render_context.hpp"
 
-#include <bnb/effect_player/utility.hpp>
+#if !BNB_STUB_EFFECT_PLAYER
+    #include <bnb/effect_player/utility.hpp>
+#endif
 
 namespace bnb::oep
 {
@@ -43,7 +45,9 @@ namespace bnb::oep
         if (0 == gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
             throw std::runtime_error("gladLoadGLLoader error");
         }
+#if !BNB_STUB_EFFECT_PLAYER
         bnb::utility::load_gl_functions();
+#endif
     }
 
     /* render_context::activate */
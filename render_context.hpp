@@ -4,6 +4,10 @@
 #include "libraries/utils/glfw_window.hpp"
 #include "libraries/renderer/renderer.hpp"
 
+#if BNB_HEADLESS_RENDER_CONTEXT
+#include <EGL/egl.h>
+#endif
+
 namespace bnb::oep
 {
 
@@ -20,7 +24,13 @@ namespace bnb::oep
 
         void * get_sharing_context() override;
     private:
+#if BNB_HEADLESS_RENDER_CONTEXT
+        EGLDisplay m_display {EGL_NO_DISPLAY};
+        EGLSurface m_surface {EGL_NO_SURFACE}; /* 1x1 pbuffer, only if surfaceless contexts are not supported */
+        EGLContext m_context {EGL_NO_CONTEXT};
+#else
         GLFWwindow * m_context;
+#endif
     }; /* class render_context */
 
 } /* namespace bnb::oep */
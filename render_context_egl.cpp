@@ -0,0 +1,153 @@
+#include "render_context.hpp"
+
+#if !BNB_STUB_EFFECT_PLAYER
+    #include <bnb/effect_player/utility.hpp>
+#endif
+
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+    bool has_extension(const char* extensions, const char* name)
+    {
+        return extensions != nullptr && std::strstr(extensions, name) != nullptr;
+    }
+
+    EGLDisplay get_headless_display()
+    {
+        // Mesa surfaceless platform works without X11/Wayland and without a GPU (llvmpipe)
+        auto client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display != nullptr && has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+            return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+} /* namespace */
+
+namespace bnb::oep
+{
+
+    /* interfaces::render_context::create */
+    render_context_sptr bnb::oep::interfaces::render_context::create()
+    {
+        return std::make_shared<bnb::oep::render_context>();
+    }
+
+    /* render_context::render_context */
+    render_context::render_context()
+    {
+        m_display = get_headless_display();
+        if (m_display == EGL_NO_DISPLAY) {
+            throw std::runtime_error("eglGetDisplay() error");
+        }
+        // eglInitialize is a no-op for an already initialized display
+        if (!eglInitialize(m_display, nullptr, nullptr)) {
+            throw std::runtime_error("eglInitialize() error");
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            throw std::runtime_error("eglBindAPI() error");
+        }
+
+        auto display_extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+        bool surfaceless = has_extension(display_extensions, "EGL_KHR_surfaceless_context");
+
+        const EGLint config_attribs[] = {
+            EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_NONE
+        };
+        EGLConfig config = nullptr;
+        EGLint configs_count = 0;
+        if (!eglChooseConfig(m_display, config_attribs, &config, 1, &configs_count) || configs_count == 0) {
+            throw std::runtime_error("eglChooseConfig() error");
+        }
+
+        const EGLint context_attribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION_KHR, 4,
+            EGL_CONTEXT_MINOR_VERSION_KHR, 1,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+            EGL_CONTEXT_FLAGS_KHR, EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR,
+            EGL_NONE
+        };
+        // Without EGL_KHR_create_context the attributes above are errors, the driver default context is created then
+        const EGLint default_context_attribs[] = {EGL_NONE};
+        bool create_context_supported = has_extension(display_extensions, "EGL_KHR_create_context");
+        if (!create_context_supported) {
+            std::cout << "[INFO] EGL_KHR_create_context is not supported, creating the default OpenGL context" << std::endl;
+        }
+        m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, create_context_supported ? context_attribs : default_context_attribs);
+        if (m_context == EGL_NO_CONTEXT) {
+            throw std::runtime_error("eglCreateContext() error");
+        }
+
+        if (!surfaceless) {
+            const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+            m_surface = eglCreatePbufferSurface(m_display, config, pbuffer_attribs);
+            if (m_surface == EGL_NO_SURFACE) {
+                eglDestroyContext(m_display, m_context);
+                throw std::runtime_error("eglCreatePbufferSurface() error");
+            }
+        }
+    }
+
+    /* render_context::~render_context */
+    render_context::~render_context()
+    {
+        // The display is shared by all instances in the process, so it is not terminated here
+        if (m_surface != EGL_NO_SURFACE) {
+            eglDestroySurface(m_display, m_surface);
+        }
+        eglDestroyContext(m_display, m_context);
+    }
+
+    /* render_context::create_context */
+    void render_context::create_context()
+    {
+        activate();
+        if (0 == gladLoadGLLoader((GLADloadproc) eglGetProcAddress)) {
+            throw std::runtime_error("gladLoadGLLoader error");
+        }
+#if !BNB_STUB_EFFECT_PLAYER
+        bnb::utility::load_gl_functions();
+#endif
+    }
+
+    /* render_context::activate */
+    void render_context::activate()
+    {
+        // The bound API is per-thread EGL state, and the OEP activates the context on its own thread
+        eglBindAPI(EGL_OPENGL_API);
+        if (m_context != EGL_NO_CONTEXT) {
+            eglMakeCurrent(m_display, m_surface, m_surface, m_context);
+        }
+    }
+
+    /* render_context::deactivate */
+    void render_context::deactivate()
+    {
+        // Releases the context of the bound API only, which must be the desktop OpenGL one here
+        eglBindAPI(EGL_OPENGL_API);
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    /* render_context::delete_context */
+    void render_context::delete_context()
+    {}
+
+    /* render_context::get_sharing_context */
+    void * render_context::get_sharing_context()
+    {
+        return m_context;
+    }
+
+} /* namespace bnb::oep */
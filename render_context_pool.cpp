@@ -0,0 +1,237 @@
+#include "render_context_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+
+namespace bnb::oep
+{
+
+    namespace
+    {
+
+        // Resets what effect players commonly change to the GL defaults, so the next render
+        // context using the shared context starts from a known state
+        void reset_gl_state()
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glUseProgram(0);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindSampler(0, 0);
+            glDisable(GL_BLEND);
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_STENCIL_TEST);
+            glDisable(GL_SCISSOR_TEST);
+            glDisable(GL_CULL_FACE);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glDepthMask(GL_TRUE);
+        }
+
+    } /* namespace */
+
+    // A GL context locked by one thread at a time, from activate() to deactivate()
+    class render_context_pool::shared_context
+    {
+    public:
+        // The context locked by the calling thread
+        static thread_local shared_context* held_context;
+
+        shared_context()
+            : m_context(std::make_unique<bnb::oep::render_context>())
+        {
+        }
+
+        // Waits until no other thread holds the context and makes it current on the calling thread,
+        // user is the render context locking it
+        void lock(const void* user)
+        {
+            // Holding one context while waiting for another may deadlock with a thread doing the opposite
+            assert((held_context == nullptr || held_context == this) && "a thread may hold one pooled context at most");
+
+            auto self = std::this_thread::get_id();
+            bool reset_state = false;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                ++m_statistics.activations;
+                if (m_owner == self) {
+                    return;
+                }
+                if (m_owner != std::thread::id()) {
+                    ++m_statistics.contended_activations;
+                    m_released.wait(lock, [this]() { return m_owner == std::thread::id(); });
+                }
+                m_owner = self;
+                ++m_statistics.context_switches;
+                reset_state = m_is_gl_loaded && m_last_user != user;
+                if (reset_state) {
+                    ++m_statistics.state_resets;
+                }
+                m_last_user = user;
+            }
+            held_context = this;
+            m_context->activate();
+            if (reset_state) {
+                reset_gl_state();
+            }
+        }
+
+        // Does nothing if the calling thread does not hold the context
+        void unlock()
+        {
+            if (!is_held_by_this_thread()) {
+                return;
+            }
+            // Released before unlocking, a context may be current on one thread only
+            m_context->deactivate();
+            held_context = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_owner = std::thread::id();
+            }
+            m_released.notify_one();
+        }
+
+        // Must be called with the context locked
+        void load_gl_functions()
+        {
+            if (!m_is_gl_loaded) {
+                m_context->create_context();
+                m_is_gl_loaded = true;
+            }
+        }
+
+        bool is_held_by_this_thread() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_owner == std::this_thread::get_id();
+        }
+
+        void* get_sharing_context()
+        {
+            return m_context->get_sharing_context();
+        }
+
+        void add_user(int32_t delta)
+        {
+            m_users += delta;
+        }
+
+        void append_statistics(render_context_pool::statistics& statistics) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            statistics.users.push_back(m_users);
+            statistics.activations += m_statistics.activations;
+            statistics.context_switches += m_statistics.context_switches;
+            statistics.contended_activations += m_statistics.contended_activations;
+            statistics.state_resets += m_statistics.state_resets;
+        }
+
+    private:
+        const std::unique_ptr<bnb::oep::render_context> m_context;
+        bool m_is_gl_loaded {false}; /* set by the thread holding the context */
+        std::atomic<int32_t> m_users {0};
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_released;
+        std::thread::id m_owner;
+        const void* m_last_user {nullptr};
+        render_context_pool::statistics m_statistics;
+    }; /* class render_context_pool::shared_context */
+
+    thread_local render_context_pool::shared_context* render_context_pool::shared_context::held_context = nullptr;
+
+    // The render context of one OEP, backed by a shared context of the pool
+    class render_context_pool::pooled_render_context : public bnb::oep::interfaces::render_context
+    {
+    public:
+        explicit pooled_render_context(std::shared_ptr<shared_context> context)
+            : m_context(std::move(context))
+        {
+            m_context->add_user(1);
+        }
+
+        ~pooled_render_context()
+        {
+            // The OEP may be destroyed on its render thread with the context still active
+            m_context->unlock();
+            m_context->add_user(-1);
+        }
+
+        void create_context() override
+        {
+            // The context stays current as with the non-pooled render context, until deactivate()
+            m_context->lock(this);
+            m_context->load_gl_functions();
+        }
+
+        void activate() override
+        {
+            m_context->lock(this);
+        }
+
+        void deactivate() override
+        {
+            m_context->unlock();
+        }
+
+        void delete_context() override
+        {
+        }
+
+        void* get_sharing_context() override
+        {
+            return m_context->get_sharing_context();
+        }
+
+    private:
+        const std::shared_ptr<shared_context> m_context;
+    }; /* class render_context_pool::pooled_render_context */
+
+    /* render_context_pool::create */
+    render_context_pool_sptr render_context_pool::create(int32_t contexts_count)
+    {
+        return std::make_shared<render_context_pool>(contexts_count);
+    }
+
+    /* render_context_pool::render_context_pool */
+    render_context_pool::render_context_pool(int32_t contexts_count)
+    {
+        contexts_count = std::max(1, contexts_count);
+        m_contexts.reserve(contexts_count);
+        for (int32_t i = 0; i < contexts_count; ++i) {
+            m_contexts.push_back(std::make_shared<shared_context>());
+        }
+    }
+
+    /* render_context_pool::acquire */
+    render_context_sptr render_context_pool::acquire(uint32_t affinity)
+    {
+        // Render contexts keep their shared context alive, the pool may be destroyed before them
+        return std::make_shared<pooled_render_context>(m_contexts[affinity % m_contexts.size()]);
+    }
+
+    /* render_context_pool::release_thread_context */
+    void render_context_pool::release_thread_context()
+    {
+        if (auto context = shared_context::held_context) {
+            context->unlock();
+        }
+    }
+
+    /* render_context_pool::get_statistics */
+    render_context_pool::statistics render_context_pool::get_statistics() const
+    {
+        statistics statistics;
+        for (const auto& context : m_contexts) {
+            context->append_statistics(statistics);
+        }
+        return statistics;
+    }
+
+} /* namespace bnb::oep */
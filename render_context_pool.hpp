@@ -0,0 +1,80 @@
+#pragma once
+
+#include "render_context.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bnb::oep
+{
+
+    class render_context_pool;
+    using render_context_pool_sptr = std::shared_ptr<render_context_pool>;
+
+    // A fixed number of GL contexts time-shared by OEP instances, instead of a context (and on
+    // desktop a hidden GLFW window) per OEP. Render contexts returned by acquire() lock their shared
+    // context in activate() and unlock it in deactivate(), so the OEP threads using the same context
+    // take turns. Activating a context the calling thread holds already does not switch it.
+    //
+    // An OEP may keep its context current between frames and never call deactivate(), which would
+    // block the other OEPs of the context for good. The owner of the OEP therefore calls
+    // release_thread_context() at the end of every OEP task doing GL work: once a frame is processed,
+    // on the thread the result callback runs on, and after the tasks without a result (creation,
+    // effect loads, JS calls), e.g. from the effect player the OEP calls (stream_manager does both).
+    // An idle OEP then holds no context. This requires the OEP to call activate() at the start of every task
+    // doing GL work, as the OEP render target does, and not to touch GL after the result callback
+    // of a frame without activating again. A thread holds one pooled context at most, which is asserted.
+    //
+    // GL objects of the OEPs sharing a context live in the same namespace, which is fine as long
+    // as every OEP binds its own objects in each activation. The GL state is not saved per OEP: when
+    // another render context takes the shared context, the bindings and the capabilities an effect
+    // player may leave changed are reset to the GL defaults, so no OEP sees the state of another one.
+    class render_context_pool
+    {
+    public:
+        struct statistics
+        {
+            // Render contexts using each shared context
+            std::vector<int32_t> users;
+            uint64_t activations {0};
+            // Activations which made the context current, the rest found it current already
+            uint64_t context_switches {0};
+            // Activations which waited for another thread to deactivate the context
+            uint64_t contended_activations {0};
+            // Activations by another render context than the previous one, the GL state was reset
+            uint64_t state_resets {0};
+        };
+
+        // Throws std::runtime_error if the contexts cannot be created
+        static render_context_pool_sptr create(int32_t contexts_count);
+
+        // Use create()
+        explicit render_context_pool(int32_t contexts_count);
+
+        // Returns a render context backed by the shared context affinity % contexts_count, so
+        // consecutive affinities (e.g. stream ids) spread over the contexts evenly
+        render_context_sptr acquire(uint32_t affinity);
+
+        [[nodiscard]] int32_t get_contexts_count() const
+        {
+            return static_cast<int32_t>(m_contexts.size());
+        }
+
+        statistics get_statistics() const;
+
+        // Unlocks the pooled context held by the calling thread, if any. Called at the end of every
+        // OEP task, e.g. when a frame is processed and its result is taken, see the class comment.
+        static void release_thread_context();
+
+    private:
+        class shared_context;
+        class pooled_render_context;
+
+    private:
+        std::vector<std::shared_ptr<shared_context>> m_contexts;
+    }; /* class render_context_pool */
+
+} /* namespace bnb::oep */
@@ -0,0 +1,411 @@
+#include "stream_manager.hpp"
+
+#include "render_context_pool.hpp"
+#include "libraries/trace/frame_trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace bnb
+{
+
+    namespace
+    {
+
+        // The OEP calls its effect player on its worker thread, and each of these calls ends an OEP
+        // task: load_effect, JS calls, creation and the state changes. The OEP keeps its render
+        // context current after such a task, so a context shared by a pool is released here, not
+        // only after frame results, and an idle stream does not block the others of its context.
+        // surface_changed is followed by GL work of the render target and frames by the result,
+        // so push_frame, draw and surface_changed keep the context.
+        class context_releasing_effect_player : public bnb::oep::interfaces::effect_player
+        {
+        public:
+            explicit context_releasing_effect_player(effect_player_sptr ep)
+                : m_ep(std::move(ep))
+            {
+            }
+
+            void surface_created(int32_t width, int32_t height) override
+            {
+                m_ep->surface_created(width, height);
+                bnb::oep::render_context_pool::release_thread_context();
+            }
+
+            void surface_changed(int32_t width, int32_t height) override
+            {
+                m_ep->surface_changed(width, height);
+            }
+
+            void surface_destroyed() override
+            {
+                m_ep->surface_destroyed();
+                bnb::oep::render_context_pool::release_thread_context();
+            }
+
+            bool load_effect(const std::string& effect) override
+            {
+                auto loaded = m_ep->load_effect(effect);
+                bnb::oep::render_context_pool::release_thread_context();
+                return loaded;
+            }
+
+            bool call_js_method(const std::string& method, const std::string& param) override
+            {
+                auto called = m_ep->call_js_method(method, param);
+                bnb::oep::render_context_pool::release_thread_context();
+                return called;
+            }
+
+            void eval_js(const std::string& script, oep_eval_js_result_cb result_callback) override
+            {
+                m_ep->eval_js(script, std::move(result_callback));
+                bnb::oep::render_context_pool::release_thread_context();
+            }
+
+            void pause() override
+            {
+                m_ep->pause();
+                bnb::oep::render_context_pool::release_thread_context();
+            }
+
+            void resume() override
+            {
+                m_ep->resume();
+                bnb::oep::render_context_pool::release_thread_context();
+            }
+
+            void stop() override
+            {
+                m_ep->stop();
+                bnb::oep::render_context_pool::release_thread_context();
+            }
+
+            void push_frame(pixel_buffer_sptr image, bnb::oep::interfaces::rotation image_orientation, bool require_mirroring) override
+            {
+                m_ep->push_frame(std::move(image), image_orientation, require_mirroring);
+            }
+
+            int64_t draw() override
+            {
+                return m_ep->draw();
+            }
+
+        private:
+            const effect_player_sptr m_ep;
+        }; /* class context_releasing_effect_player */
+
+    } /* namespace */
+
+    struct stream_manager::stream
+    {
+        using clock = std::chrono::steady_clock;
+
+        stream_id id {0};
+        stream_config config;
+        result_cb callback;
+        offscreen_effect_player_sptr oep;
+        frame_throttler_sptr throttler;
+
+        // Taken by frames when they are submitted, a frame waiting in the throttler gets the latest ones
+        std::atomic<bnb::oep::interfaces::rotation> orientation {bnb::oep::interfaces::rotation::deg0};
+        std::atomic_bool require_mirroring {false};
+
+        // Guarded by stream_manager::m_retire_mutex
+        int32_t frames_in_oep {0};
+        bool retired {false};
+
+        mutable std::mutex mutex; /* guards the fields below */
+        uint64_t frames_processed {0};
+        uint64_t frames_failed {0};
+        std::optional<clock::time_point> first_submit;
+        clock::time_point last_result;
+        double total_latency_ms {0.0};
+        double max_latency_ms {0.0};
+    }; /* struct stream_manager::stream */
+
+    /* stream_manager::stream_manager */
+    stream_manager::stream_manager(render_context_factory factory)
+        : m_render_context_factory(factory ? std::move(factory) : [](stream_id) { return bnb::oep::interfaces::render_context::create(); })
+        , m_retire_thread([this]() { run_retire_loop(); })
+    {
+    }
+
+    /* stream_manager::~stream_manager */
+    stream_manager::~stream_manager()
+    {
+        std::map<stream_id, stream_sptr> streams;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            streams.swap(m_streams);
+        }
+        for (auto& [id, s] : streams) {
+            retire(std::move(s));
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_retire_mutex);
+            m_stopping = true;
+        }
+        m_retire_condition.notify_all();
+        // Returns when every stream has got its frames back and is destroyed
+        m_retire_thread.join();
+    }
+
+    /* stream_manager::add_stream */
+    stream_id stream_manager::add_stream(const stream_config& config, result_cb callback)
+    {
+        if (config.width <= 0 || config.height <= 0) {
+            throw std::runtime_error("Stream size must be positive");
+        }
+
+        auto s = std::make_shared<stream>();
+        s->config = config;
+        s->callback = std::move(callback);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            s->id = m_next_id++;
+        }
+
+        // Each stream has its own OEP stack, as in the single stream example
+        auto rc = m_render_context_factory(s->id);
+        if (rc == nullptr) {
+            throw std::runtime_error("Unable to create a render context for the stream");
+        }
+        auto ort = bnb::oep::interfaces::offscreen_render_target::create(rc);
+        auto ep = std::make_shared<context_releasing_effect_player>(bnb::oep::interfaces::effect_player::create(config.width, config.height));
+        s->oep = bnb::oep::interfaces::offscreen_effect_player::create(ep, ort, config.width, config.height);
+        if (!config.effect.empty()) {
+            s->oep->load_effect(config.effect);
+        }
+
+        // The throttler is owned by the stream, and the stream is kept alive by the manager until its
+        // OEP has returned every frame counted by begin_frame, so the callbacks take a raw pointer. The
+        // submit callback runs either in push_frame, which holds the stream, or in the result callback
+        // of another frame of the stream.
+        s->throttler = frame_throttler::create(config.max_frames_in_flight, config.drop_policy, [this, s = s.get()](pixel_buffer_sptr image, frame_throttler::frame_done_cb done) {
+            if (!begin_frame(*s)) {
+                done();
+                return;
+            }
+
+            auto start = stream::clock::now();
+            {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if (!s->first_submit.has_value()) {
+                    s->first_submit = start;
+                }
+            }
+            bnb::trace::record(bnb::trace::find(image.get()), bnb::trace::stage::submitted);
+
+            auto process_callback = [this, s, done, start](image_processing_result_sptr result) {
+                if (s->callback) {
+                    s->callback(s->id, result);
+                }
+                // The result is taken, a context shared with other streams is handed over to them,
+                // the OEP activates its render context again for the next frame
+                bnb::oep::render_context_pool::release_thread_context();
+
+                auto now = stream::clock::now();
+                auto latency_ms = std::chrono::duration<double, std::milli>(now - start).count();
+                {
+                    std::lock_guard<std::mutex> lock(s->mutex);
+                    if (result != nullptr) {
+                        ++s->frames_processed;
+                        s->total_latency_ms += latency_ms;
+                        s->max_latency_ms = std::max(s->max_latency_ms, latency_ms);
+                        s->last_result = now;
+                    } else {
+                        ++s->frames_failed;
+                    }
+                }
+                // The frame is processed (or lost), the next one may be submitted
+                done();
+                end_frame(*s);
+            };
+            s->oep->process_image_async(image, s->orientation, s->require_mirroring, process_callback, bnb::oep::interfaces::rotation::deg0);
+        });
+        s->throttler->set_block_timeout(config.block_timeout);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_streams.emplace(s->id, s);
+        return s->id;
+    }
+
+    /* stream_manager::remove_stream */
+    bool stream_manager::remove_stream(stream_id id)
+    {
+        stream_sptr s;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_streams.find(id);
+            if (it == m_streams.end()) {
+                return false;
+            }
+            s = std::move(it->second);
+            m_streams.erase(it);
+        }
+        retire(std::move(s));
+        return true;
+    }
+
+    /* stream_manager::push_frame */
+    bool stream_manager::push_frame(stream_id id, pixel_buffer_sptr image, bnb::oep::interfaces::rotation orientation, bool require_mirroring)
+    {
+        auto s = find_stream(id);
+        if (!s) {
+            return false;
+        }
+        s->orientation = orientation;
+        s->require_mirroring = require_mirroring;
+        // Not under m_mutex, the block policy may wait here for the stream's OEP
+        return s->throttler->push(std::move(image));
+    }
+
+    /* stream_manager::load_effect */
+    bool stream_manager::load_effect(stream_id id, const std::string& effect)
+    {
+        if (auto s = find_stream(id)) {
+            s->oep->load_effect(effect);
+            return true;
+        }
+        return false;
+    }
+
+    /* stream_manager::call_js_method */
+    bool stream_manager::call_js_method(stream_id id, const std::string& method, const std::string& param)
+    {
+        if (auto s = find_stream(id)) {
+            s->oep->call_js_method(method, param);
+            return true;
+        }
+        return false;
+    }
+
+    /* stream_manager::get_statistics */
+    std::optional<stream_manager::stream_statistics> stream_manager::get_statistics(stream_id id) const
+    {
+        if (auto s = find_stream(id)) {
+            return make_statistics(*s);
+        }
+        return std::nullopt;
+    }
+
+    /* stream_manager::get_statistics */
+    std::vector<stream_manager::stream_statistics> stream_manager::get_statistics() const
+    {
+        std::vector<stream_sptr> streams;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            streams.reserve(m_streams.size());
+            for (auto& [id, s] : m_streams) {
+                streams.push_back(s);
+            }
+        }
+
+        std::vector<stream_statistics> statistics;
+        statistics.reserve(streams.size());
+        for (auto& s : streams) {
+            statistics.push_back(make_statistics(*s));
+        }
+        return statistics;
+    }
+
+    /* stream_manager::get_streams_count */
+    size_t stream_manager::get_streams_count() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_streams.size();
+    }
+
+    /* stream_manager::find_stream */
+    stream_manager::stream_sptr stream_manager::find_stream(stream_id id) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_streams.find(id);
+        return it != m_streams.end() ? it->second : nullptr;
+    }
+
+    /* stream_manager::begin_frame */
+    bool stream_manager::begin_frame(stream& s)
+    {
+        std::lock_guard<std::mutex> lock(m_retire_mutex);
+        if (s.retired) {
+            return false;
+        }
+        ++s.frames_in_oep;
+        return true;
+    }
+
+    /* stream_manager::end_frame */
+    void stream_manager::end_frame(stream& s)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_retire_mutex);
+            --s.frames_in_oep;
+        }
+        m_retire_condition.notify_all();
+    }
+
+    /* stream_manager::retire */
+    void stream_manager::retire(stream_sptr s)
+    {
+        // Releases producers blocked in push_frame
+        s->throttler->reset();
+        {
+            std::lock_guard<std::mutex> lock(m_retire_mutex);
+            s->retired = true;
+            m_retired_streams.push_back(std::move(s));
+        }
+        m_retire_condition.notify_all();
+    }
+
+    /* stream_manager::run_retire_loop */
+    void stream_manager::run_retire_loop()
+    {
+        auto is_drained = [](const stream_sptr& s) { return s->frames_in_oep == 0; };
+
+        std::unique_lock<std::mutex> lock(m_retire_mutex);
+        while (true) {
+            m_retire_condition.wait(lock, [this, &is_drained]() {
+                return (m_stopping && m_retired_streams.empty()) || std::any_of(m_retired_streams.begin(), m_retired_streams.end(), is_drained);
+            });
+            if (m_retired_streams.empty()) {
+                return;
+            }
+
+            auto it = std::stable_partition(m_retired_streams.begin(), m_retired_streams.end(), [&is_drained](const stream_sptr& s) { return !is_drained(s); });
+            std::vector<stream_sptr> drained(std::make_move_iterator(it), std::make_move_iterator(m_retired_streams.end()));
+            m_retired_streams.erase(it, m_retired_streams.end());
+
+            // Destroying an OEP joins its worker thread, so it is done here without the lock
+            lock.unlock();
+            drained.clear();
+            lock.lock();
+        }
+    }
+
+    /* stream_manager::make_statistics */
+    stream_manager::stream_statistics stream_manager::make_statistics(const stream& s)
+    {
+        stream_statistics statistics;
+        statistics.id = s.id;
+        statistics.width = s.config.width;
+        statistics.height = s.config.height;
+        statistics.frames = s.throttler->get_statistics();
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        statistics.frames_processed = s.frames_processed;
+        statistics.frames_failed = s.frames_failed;
+        if (s.frames_processed > 0) {
+            statistics.average_latency_ms = s.total_latency_ms / static_cast<double>(s.frames_processed);
+            statistics.max_latency_ms = s.max_latency_ms;
+            std::chrono::duration<double> elapsed = s.last_result - *s.first_submit;
+            if (elapsed.count() > 0.0) {
+                statistics.fps = static_cast<double>(s.frames_processed) / elapsed.count();
+            }
+        }
+        return statistics;
+    }
+
+} /* namespace bnb */
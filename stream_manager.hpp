@@ -0,0 +1,133 @@
+#pragma once
+
+#include <interfaces/offscreen_effect_player.hpp>
+#include <interfaces/render_context.hpp>
+
+#include "frame_throttler.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bnb
+{
+
+    using stream_id = uint32_t;
+
+    struct stream_config
+    {
+        // Size of frames pushed into the stream, the effect is rendered in the same size
+        int32_t width {640};
+        int32_t height {360};
+        // Loaded when the stream is added, may be empty
+        std::string effect;
+        // Frames submitted to the stream's OEP and not yet returned, see frame_throttler
+        int32_t max_frames_in_flight {1};
+        frame_drop_policy drop_policy {frame_drop_policy::drop_oldest};
+        // How long the block policy waits for a free slot, frame_throttler::no_block_timeout never drops
+        std::chrono::milliseconds block_timeout {frame_throttler::default_block_timeout};
+    };
+
+    // Hosts independent OEP pipelines (render context, render target, effect player and OEP) for
+    // many streams in one process, e.g. the participants of a video call. The Banuba SDK must be
+    // initialized once per process with bnb::utility before streams are added, all streams share it.
+    class stream_manager
+    {
+    public:
+        // Creates the render context of a new stream, render_context::create() by default
+        using render_context_factory = std::function<render_context_sptr(stream_id id)>;
+        // Receives every processed frame of the stream, or nullptr if the OEP failed to process it.
+        // The frame slot is freed when the callback returns, so the result is taken here
+        // (get_texture or get_image), the same as in the single stream example. A pooled render
+        // context held by the OEP thread is released when the callback returns.
+        using result_cb = std::function<void(stream_id id, image_processing_result_sptr result)>;
+
+        struct stream_statistics
+        {
+            stream_id id {0};
+            int32_t width {0};
+            int32_t height {0};
+            frame_throttler::statistics frames;
+            uint64_t frames_processed {0};
+            uint64_t frames_failed {0};
+            // Processed frames per second since the first frame was submitted
+            double fps {0.0};
+            // From process_image_async to the result callback
+            double average_latency_ms {0.0};
+            double max_latency_ms {0.0};
+        };
+
+        explicit stream_manager(render_context_factory factory = nullptr);
+
+        // Removes all streams and waits until the frames they have in flight are returned
+        ~stream_manager();
+
+        stream_manager(const stream_manager&) = delete;
+        stream_manager& operator=(const stream_manager&) = delete;
+
+        // Creates the OEP pipeline of a new stream, throws std::runtime_error if it cannot be created
+        stream_id add_stream(const stream_config& config, result_cb callback);
+
+        // Frames of the stream still in flight are not reported. The stream is destroyed on the
+        // manager's own thread once its OEP has returned them, never on the OEP's worker thread.
+        bool remove_stream(stream_id id);
+
+        // Submits the frame to the stream's OEP or drops it according to the stream's drop policy,
+        // returns false if there is no such stream or the frame is dropped
+        bool push_frame(stream_id id, pixel_buffer_sptr image, bnb::oep::interfaces::rotation orientation = bnb::oep::interfaces::rotation::deg0, bool require_mirroring = false);
+
+        bool load_effect(stream_id id, const std::string& effect);
+
+        bool call_js_method(stream_id id, const std::string& method, const std::string& param);
+
+        std::optional<stream_statistics> get_statistics(stream_id id) const;
+
+        // Statistics of all streams ordered by stream id
+        std::vector<stream_statistics> get_statistics() const;
+
+        size_t get_streams_count() const;
+
+    private:
+        struct stream;
+        using stream_sptr = std::shared_ptr<stream>;
+
+        stream_sptr find_stream(stream_id id) const;
+
+        // Counts a frame passed to the stream's OEP, returns false if the stream is removed
+        bool begin_frame(stream& s);
+
+        // The OEP returned the frame, the stream must not be touched after that
+        void end_frame(stream& s);
+
+        // Stops taking frames for the stream and hands it to the retire thread
+        void retire(stream_sptr s);
+
+        // Destroys removed streams once they have no frames in flight
+        void run_retire_loop();
+
+        static stream_statistics make_statistics(const stream& s);
+
+    private:
+        const render_context_factory m_render_context_factory;
+
+        mutable std::mutex m_mutex;
+        std::map<stream_id, stream_sptr> m_streams;
+        stream_id m_next_id {1};
+
+        // Removed streams wait here for their frames in flight, the OEP callbacks reference streams
+        // by raw pointers, so the last reference must not be dropped by the OEP's worker thread
+        std::mutex m_retire_mutex;
+        std::condition_variable m_retire_condition;
+        std::vector<stream_sptr> m_retired_streams;
+        bool m_stopping {false};
+        std::thread m_retire_thread;
+    }; /* class stream_manager */
+
+} /* namespace bnb */
@@ -0,0 +1,220 @@
+#include "frame_throttler.hpp"
+#include "libraries/pixel_buffer_pool/pixel_buffer_pool.hpp"
+#include "test_utils.hpp"
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Checks the three drop policies and reset() of frame_throttler with a fake OEP which returns
+// frames only when the test tells it to
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+
+    // Keeps the submitted frames and their done callbacks, called from the pushing thread or from
+    // the thread returning another frame
+    class fake_oep
+    {
+    public:
+        bnb::frame_throttler::submit_cb make_submit()
+        {
+            return [this](pixel_buffer_sptr image, bnb::frame_throttler::frame_done_cb done) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_frames.emplace_back(std::move(image), std::move(done));
+            };
+        }
+
+        // Returns the i-th submitted frame to the throttler
+        void finish(size_t i)
+        {
+            bnb::frame_throttler::frame_done_cb done;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                done = m_frames.at(i).second;
+            }
+            done();
+        }
+
+        size_t get_submitted_count() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_frames.size();
+        }
+
+        pixel_buffer_sptr get_submitted(size_t i) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_frames.at(i).first;
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<std::pair<pixel_buffer_sptr, bnb::frame_throttler::frame_done_cb>> m_frames;
+    }; /* class fake_oep */
+
+    class frames
+    {
+    public:
+        // Every frame is a separate buffer, so the submitted ones can be told apart
+        pixel_buffer_sptr next()
+        {
+            m_frames.push_back(m_pool->acquire(bnb::oep::interfaces::image_format::bpc8_rgba, 2, 2));
+            return m_frames.back();
+        }
+
+    private:
+        bnb::pixel_buffer_pool_sptr m_pool {bnb::pixel_buffer_pool::create()};
+        std::vector<pixel_buffer_sptr> m_frames;
+    }; /* class frames */
+
+    // Waits until a producer thread has entered push()
+    void wait_for_pushes(const bnb::frame_throttler& throttler, uint64_t pushes)
+    {
+        while (throttler.get_statistics().frames_pushed < pushes) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    void test_drop_newest(bnb::test::checker& c)
+    {
+        fake_oep oep;
+        frames f;
+        auto throttler = bnb::frame_throttler::create(1, bnb::frame_drop_policy::drop_newest, oep.make_submit());
+
+        auto a = f.next(), b = f.next(), d = f.next();
+        c.expect(throttler->push(a), "drop_newest: a frame with a free slot is submitted");
+        c.expect(!throttler->push(b), "drop_newest: a frame arriving at a full window is dropped");
+        oep.finish(0);
+        c.expect(throttler->push(d), "drop_newest: the freed slot takes the next frame");
+
+        auto s = throttler->get_statistics();
+        c.expect(oep.get_submitted_count() == 2 && oep.get_submitted(1) == d, "drop_newest: the dropped frame is never submitted");
+        c.expect(s.frames_pushed == 3 && s.frames_submitted == 2 && s.frames_dropped == 1, "drop_newest: statistics");
+        c.expect(s.frames_in_flight == 1 && !s.has_waiting_frame, "drop_newest: one frame in flight, none waiting");
+    }
+
+    void test_drop_oldest(bnb::test::checker& c)
+    {
+        fake_oep oep;
+        frames f;
+        auto throttler = bnb::frame_throttler::create(1, bnb::frame_drop_policy::drop_oldest, oep.make_submit());
+
+        auto a = f.next(), b = f.next(), d = f.next();
+        throttler->push(a);
+        c.expect(throttler->push(b), "drop_oldest: a frame arriving at a full window waits");
+        c.expect(throttler->get_statistics().has_waiting_frame, "drop_oldest: the waiting frame is reported");
+        c.expect(throttler->push(d), "drop_oldest: a newer frame replaces the waiting one");
+        c.expect(oep.get_submitted_count() == 1, "drop_oldest: waiting frames are not submitted before a slot is freed");
+
+        // The freed slot goes to the waiting frame right away, on the thread returning the frame
+        oep.finish(0);
+        auto s = throttler->get_statistics();
+        c.expect(oep.get_submitted_count() == 2 && oep.get_submitted(1) == d, "drop_oldest: the freshest frame takes the freed slot");
+        c.expect(s.frames_pushed == 3 && s.frames_submitted == 2 && s.frames_dropped == 1, "drop_oldest: statistics");
+        c.expect(s.frames_in_flight == 1 && !s.has_waiting_frame, "drop_oldest: the waiting frame is in flight now");
+
+        // Leaving the policy drops the waiting frame
+        throttler->push(f.next());
+        throttler->set_policy(bnb::frame_drop_policy::drop_newest);
+        s = throttler->get_statistics();
+        c.expect(!s.has_waiting_frame && s.frames_dropped == 2, "drop_oldest: set_policy drops the waiting frame");
+    }
+
+    void test_block(bnb::test::checker& c)
+    {
+        fake_oep oep;
+        frames f;
+        auto throttler = bnb::frame_throttler::create(1, bnb::frame_drop_policy::block, oep.make_submit());
+
+        auto a = f.next(), b = f.next();
+        throttler->push(a);
+        auto pushed = std::async(std::launch::async, [&throttler, b]() { return throttler->push(b); });
+        wait_for_pushes(*throttler, 2);
+        c.expect(pushed.wait_for(30ms) == std::future_status::timeout, "block: the producer waits while the window is full");
+
+        oep.finish(0);
+        c.expect(pushed.get(), "block: the waiting frame is submitted once a slot is freed");
+        c.expect(oep.get_submitted_count() == 2 && oep.get_submitted(1) == b, "block: the frame waited for is the one submitted");
+
+        // Nothing returns the frame in flight, the bounded wait gives up
+        throttler->set_block_timeout(20ms);
+        auto start = std::chrono::steady_clock::now();
+        c.expect(!throttler->push(f.next()), "block: a frame is dropped when no slot is freed in time");
+        c.expect(std::chrono::steady_clock::now() - start >= 20ms, "block: the producer waited for the timeout");
+
+        auto s = throttler->get_statistics();
+        c.expect(s.frames_pushed == 3 && s.frames_submitted == 2 && s.frames_dropped == 1, "block: statistics");
+    }
+
+    void test_reset(bnb::test::checker& c)
+    {
+        fake_oep oep;
+        frames f;
+        auto throttler = bnb::frame_throttler::create(1, bnb::frame_drop_policy::block, oep.make_submit());
+        throttler->set_block_timeout(bnb::frame_throttler::no_block_timeout);
+
+        throttler->push(f.next());
+        auto blocked = f.next();
+        auto pushed = std::async(std::launch::async, [&throttler, blocked]() { return throttler->push(blocked); });
+        wait_for_pushes(*throttler, 2);
+        c.expect(pushed.wait_for(30ms) == std::future_status::timeout, "reset: the producer waits without a timeout");
+
+        throttler->reset();
+        if (!c.expect(pushed.wait_for(1s) == std::future_status::ready, "reset: a producer blocked without a timeout is released")) {
+            // Frees a slot, so the test ends instead of waiting for good
+            throttler->set_max_frames_in_flight(2);
+        }
+        c.expect(!pushed.get(), "reset: the released frame is reported as dropped");
+        c.expect(oep.get_submitted_count() == 1, "reset: the released frame is not submitted");
+
+        // The frame of the previous generation comes back late, it must not free a slot of the new one
+        throttler->push(f.next());
+        oep.finish(0);
+        auto s = throttler->get_statistics();
+        c.expect(s.frames_in_flight == 1, "reset: a late done callback is ignored");
+        c.expect(s.frames_submitted == 2 && s.frames_dropped == 1, "reset: statistics");
+
+        // The waiting frame of drop_oldest is forgotten as well
+        throttler->set_policy(bnb::frame_drop_policy::drop_oldest);
+        throttler->push(f.next());
+        throttler->reset();
+        s = throttler->get_statistics();
+        c.expect(!s.has_waiting_frame && s.frames_in_flight == 0, "reset: the waiting frame and the frames in flight are forgotten");
+        c.expect(throttler->push(f.next()) && oep.get_submitted_count() == 3, "reset: the window is free after a reset");
+    }
+
+    void test_window(bnb::test::checker& c)
+    {
+        fake_oep oep;
+        frames f;
+        auto throttler = bnb::frame_throttler::create(3, bnb::frame_drop_policy::drop_newest, oep.make_submit());
+
+        for (int i = 0; i < 5; ++i) {
+            throttler->push(f.next());
+        }
+        auto s = throttler->get_statistics();
+        c.expect(oep.get_submitted_count() == 3 && s.frames_dropped == 2, "window: max_frames_in_flight frames are submitted");
+        c.expect(s.max_frames_in_flight_seen == 3, "window: the most frames in flight are reported");
+
+        throttler->set_max_frames_in_flight(4);
+        c.expect(throttler->push(f.next()), "window: a larger window takes another frame");
+    }
+
+} /* namespace */
+
+int main()
+{
+    bnb::test::checker c;
+    test_drop_newest(c);
+    test_drop_oldest(c);
+    test_block(c);
+    test_reset(c);
+    test_window(c);
+    return c.report();
+}
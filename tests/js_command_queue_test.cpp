@@ -0,0 +1,96 @@
+#include "js_command_queue.hpp"
+#include "test_utils.hpp"
+
+#include <string>
+#include <vector>
+
+// Checks the order and the coalescing of the commands js_command_queue hands to the effect player
+
+namespace
+{
+
+    using bnb::js_command_queue;
+
+    // "method(param)" for methods and the script itself for scripts
+    std::vector<std::string> describe(const std::vector<js_command_queue::evaluation>& commands)
+    {
+        std::vector<std::string> described;
+        for (const auto& command : commands) {
+            described.push_back(command.method.empty() ? command.script : command.method + "(" + command.param + ")");
+        }
+        return described;
+    }
+
+    void test_coalescing(bnb::test::checker& c)
+    {
+        js_command_queue queue;
+        c.expect(queue.empty(), "a new queue is empty");
+
+        // A slider sending updates, the last value is kept at the position of the first call
+        queue.push_method("setZoom", "1");
+        queue.push_method("setColor", "red");
+        queue.push_method("setZoom", "2");
+        queue.push_method("setZoom", "3");
+        c.expect(!queue.empty(), "pushed calls are queued");
+
+        auto commands = queue.take();
+        c.expect(describe(commands) == std::vector<std::string> {"setZoom(3)", "setColor(red)"}, "repeated calls of a method are coalesced in place");
+        c.expect(queue.empty() && queue.take().empty(), "take() empties the queue");
+
+        auto s = queue.get_statistics();
+        c.expect(s.calls == 4 && s.coalesced_calls == 2, "coalescing: statistics");
+        c.expect(s.last_queue_depth == 0 && s.max_queue_depth == 2, "coalescing: queue depths");
+
+        // A method called after a take is queued again, it was made already
+        queue.push_method("setZoom", "4");
+        c.expect(describe(queue.take()) == std::vector<std::string> {"setZoom(4)"}, "a method is not coalesced across take()");
+    }
+
+    void test_scripts(bnb::test::checker& c)
+    {
+        js_command_queue queue;
+        int32_t results = 0;
+
+        // The script must see setZoom(1), and the later call must not be moved before it
+        queue.push_method("setZoom", "1");
+        queue.push_script("var a = 1;", [&results](const std::string&) { ++results; });
+        queue.push_method("setZoom", "2");
+        queue.push_method("setZoom", "3");
+        queue.push_script("var a = 2;", nullptr);
+
+        auto commands = queue.take();
+        c.expect(describe(commands) == std::vector<std::string> {"setZoom(1)", "var a = 1;", "setZoom(3)", "var a = 2;"},
+            "a script splits the coalescing, every script is kept in order");
+        c.expect(commands.size() == 4 && commands[1].callback && !commands[3].callback, "scripts keep their callbacks");
+        if (commands.size() == 4 && commands[1].callback) {
+            commands[1].callback("");
+        }
+        c.expect(results == 1, "the callback of the script is the one pushed");
+
+        auto s = queue.get_statistics();
+        c.expect(s.calls == 5 && s.coalesced_calls == 1, "scripts: statistics");
+    }
+
+    void test_timing(bnb::test::checker& c)
+    {
+        using namespace std::chrono_literals;
+
+        js_command_queue queue;
+        queue.on_evaluated(3, 2ms);
+        queue.on_evaluated(1, 4ms);
+
+        auto s = queue.get_statistics();
+        c.expect(s.evaluations == 4, "timing: evaluations are summed");
+        c.expect(s.last_js_ms == 4.0 && s.max_js_ms == 4.0 && s.average_js_ms == 3.0, "timing: per frame JS time");
+    }
+
+} /* namespace */
+
+int main()
+{
+    bnb::test::checker c;
+    test_coalescing(c);
+    test_scripts(c);
+    test_timing(c);
+    return c.report();
+}
@@ -0,0 +1,303 @@
+#include "libraries/pixel_conversion/pixel_conversion.hpp"
+#include "libraries/pixel_conversion/pixel_conversion_rows.hpp"
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Checks the scalar reference against hand-computed fixtures, then runs every vectorized kernel
+// against it on frames of random sizes and strides, the outputs must match byte for byte and the
+// row padding must never be written
+
+namespace
+{
+
+    using namespace bnb::conversion;
+
+    constexpr uint8_t padding_value = 0xa5;
+    constexpr int32_t iterations = 300;
+
+    // Image plane with padded rows, the padding is filled with padding_value
+    struct plane
+    {
+        int32_t row_size {0};
+        int32_t rows {0};
+        int32_t stride {0};
+        std::vector<uint8_t> data;
+
+        plane(int32_t row_size, int32_t rows, int32_t padding)
+            : row_size(row_size)
+            , rows(rows)
+            , stride(row_size + padding)
+            , data(static_cast<size_t>(row_size + padding) * rows, padding_value)
+        {
+        }
+
+        void fill(uint8_t value)
+        {
+            for (int32_t r = 0; r < rows; ++r) {
+                std::memset(data.data() + static_cast<size_t>(r) * stride, value, row_size);
+            }
+        }
+
+        void randomize(std::mt19937& rng)
+        {
+            for (int32_t r = 0; r < rows; ++r) {
+                for (int32_t x = 0; x < row_size; ++x) {
+                    data[static_cast<size_t>(r) * stride + x] = static_cast<uint8_t>(rng());
+                }
+            }
+        }
+
+        bool is_padding_intact() const
+        {
+            for (int32_t r = 0; r < rows; ++r) {
+                for (int32_t x = row_size; x < stride; ++x) {
+                    if (data[static_cast<size_t>(r) * stride + x] != padding_value) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+
+    struct test_case
+    {
+        int32_t width {0};
+        int32_t height {0};
+        int32_t padding[3] {};
+    };
+
+    class test_runner
+    {
+    public:
+        explicit test_runner(uint32_t seed)
+            : m_rng(seed)
+        {
+        }
+
+        // Sizes below 16 pixels, around and between the vector widths, and random ones
+        test_case make_case(int32_t i)
+        {
+            static const int32_t widths[] = {1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 95};
+            constexpr auto widths_count = static_cast<int32_t>(sizeof(widths) / sizeof(widths[0]));
+
+            test_case c;
+            c.width = i < widths_count ? widths[i] : 1 + static_cast<int32_t>(m_rng() % 300);
+            c.height = 1 + static_cast<int32_t>(m_rng() % 9);
+            for (auto& p : c.padding) {
+                // Tightly packed rows in every fourth case
+                p = m_rng() % 4 == 0 ? 0 : 1 + static_cast<int32_t>(m_rng() % 67);
+            }
+            return c;
+        }
+
+        std::mt19937& rng()
+        {
+            return m_rng;
+        }
+
+        bool check(const std::string& name, instruction_set isa, const test_case& c, const plane& expected, const plane& actual)
+        {
+            bool same = expected.data == actual.data;
+            bool intact = actual.is_padding_intact();
+            if (!same || !intact) {
+                std::cout << "[ERROR] " << name << " (" << to_string(isa) << ") " << c.width << "x" << c.height
+                          << " paddings " << c.padding[0] << ", " << c.padding[1] << ", " << c.padding[2] << ": "
+                          << (same ? "" : "differs from the scalar result ") << (intact ? "" : "writes into the row padding") << std::endl;
+                ++m_failures;
+            }
+            ++m_checks;
+            return same && intact;
+        }
+
+        // Compares a kernel output with hand-computed bytes
+        bool expect(const std::string& name, instruction_set isa, const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual)
+        {
+            bool same = expected == actual;
+            if (!same) {
+                std::cout << "[ERROR] " << name << " (" << to_string(isa) << ") fixture:";
+                for (auto byte : actual) {
+                    std::cout << " " << static_cast<int>(byte);
+                }
+                std::cout << ", expected:";
+                for (auto byte : expected) {
+                    std::cout << " " << static_cast<int>(byte);
+                }
+                std::cout << std::endl;
+                ++m_failures;
+            }
+            ++m_checks;
+            return same;
+        }
+
+        [[nodiscard]] int32_t get_failures() const
+        {
+            return m_failures;
+        }
+
+        [[nodiscard]] int32_t get_checks() const
+        {
+            return m_checks;
+        }
+
+    private:
+        std::mt19937 m_rng;
+        int32_t m_failures {0};
+        int32_t m_checks {0};
+    };
+
+    int32_t chroma_size(int32_t luma_size)
+    {
+        return (luma_size + 1) / 2;
+    }
+
+    void test_packed_yuv_to_nv12(test_runner& t, const std::string& name, packed_yuv_to_nv12_fn kernels::*fn, instruction_set isa, const test_case& c)
+    {
+        // Odd widths take the whole last pixel pair from the source
+        plane src(chroma_size(c.width) * 4, c.height, c.padding[0]);
+        src.randomize(t.rng());
+
+        auto run = [&](const kernels& k, plane& y, plane& uv) {
+            (k.*fn)(src.data.data(), src.stride, y.data.data(), y.stride, uv.data.data(), uv.stride, c.width, c.height);
+        };
+        plane expected_y(c.width, c.height, c.padding[1]), actual_y = expected_y;
+        plane expected_uv(chroma_size(c.width) * 2, chroma_size(c.height), c.padding[2]), actual_uv = expected_uv;
+        run(get_scalar_kernels(), expected_y, expected_uv);
+        run(get_kernels(isa), actual_y, actual_uv);
+
+        // The reference itself must write every pixel whatever the parity of the size, so its result
+        // must not depend on what the destination held before
+        plane covered_y = expected_y, covered_uv = expected_uv;
+        covered_y.fill(static_cast<uint8_t>(~padding_value));
+        covered_uv.fill(static_cast<uint8_t>(~padding_value));
+        run(get_scalar_kernels(), covered_y, covered_uv);
+        t.check(name + " luma", instruction_set::scalar, c, expected_y, covered_y);
+        t.check(name + " chroma", instruction_set::scalar, c, expected_uv, covered_uv);
+
+        t.check(name + " luma", isa, c, expected_y, actual_y);
+        t.check(name + " chroma", isa, c, expected_uv, actual_uv);
+    }
+
+    void test_i420_to_nv12(test_runner& t, instruction_set isa, const test_case& c)
+    {
+        plane u(chroma_size(c.width), chroma_size(c.height), c.padding[0]);
+        plane v(chroma_size(c.width), chroma_size(c.height), c.padding[1]);
+        u.randomize(t.rng());
+        v.randomize(t.rng());
+
+        plane expected(chroma_size(c.width) * 2, chroma_size(c.height), c.padding[2]), actual = expected;
+        get_scalar_kernels().i420_to_nv12(u.data.data(), u.stride, v.data.data(), v.stride, expected.data.data(), expected.stride, c.width, c.height);
+        get_kernels(isa).i420_to_nv12(u.data.data(), u.stride, v.data.data(), v.stride, actual.data.data(), actual.stride, c.width, c.height);
+        t.check("i420_to_nv12", isa, c, expected, actual);
+    }
+
+    void test_nv12_to_i420(test_runner& t, instruction_set isa, const test_case& c)
+    {
+        plane uv(chroma_size(c.width) * 2, chroma_size(c.height), c.padding[0]);
+        uv.randomize(t.rng());
+
+        plane expected_u(chroma_size(c.width), chroma_size(c.height), c.padding[1]), actual_u = expected_u;
+        plane expected_v(chroma_size(c.width), chroma_size(c.height), c.padding[2]), actual_v = expected_v;
+        get_scalar_kernels().nv12_to_i420(uv.data.data(), uv.stride, expected_u.data.data(), expected_u.stride, expected_v.data.data(), expected_v.stride, c.width, c.height);
+        get_kernels(isa).nv12_to_i420(uv.data.data(), uv.stride, actual_u.data.data(), actual_u.stride, actual_v.data.data(), actual_v.stride, c.width, c.height);
+        t.check("nv12_to_i420 u", isa, c, expected_u, actual_u);
+        t.check("nv12_to_i420 v", isa, c, expected_v, actual_v);
+    }
+
+    void test_swizzle(test_runner& t, const std::string& name, swizzle_fn kernels::*fn, int32_t src_bpp, int32_t dst_bpp, instruction_set isa, const test_case& c)
+    {
+        plane src(c.width * src_bpp, c.height, c.padding[0]);
+        src.randomize(t.rng());
+
+        plane expected(c.width * dst_bpp, c.height, c.padding[1]), actual = expected;
+        (get_scalar_kernels().*fn)(src.data.data(), src.stride, expected.data.data(), expected.stride, c.width, c.height);
+        (get_kernels(isa).*fn)(src.data.data(), src.stride, actual.data.data(), actual.stride, c.width, c.height);
+        t.check(name, isa, c, expected, actual);
+    }
+
+    // Known outputs of tiny images, so a mistake shared by the reference and the vectorized kernels
+    // (a byte order, a U/V swap, a wrong average) does not pass unnoticed
+    void test_fixtures(test_runner& t, instruction_set isa)
+    {
+        const auto& k = get_kernels(isa);
+
+        // 2x3 image. YUY2 pixel pairs are Y0 U Y1 V, UYVY pairs are U Y0 V Y1. 4:2:2 has a chroma
+        // pair per row and 4:2:0 per two rows, so the chroma of rows 0 and 1 is averaged, rounding
+        // up: (100 + 101 + 1) / 2 = 101 and (200 + 150 + 1) / 2 = 175. The last row of an odd height
+        // is paired with itself and keeps its chroma.
+        const std::vector<uint8_t> yuy2 = {10, 100, 20, 200, 30, 101, 40, 150, 50, 60, 70, 80};
+        const std::vector<uint8_t> uyvy = {100, 10, 200, 20, 101, 30, 150, 40, 60, 50, 80, 70};
+        const std::vector<uint8_t> expected_y = {10, 20, 30, 40, 50, 70};
+        const std::vector<uint8_t> expected_uv = {101, 175, 60, 80};
+        std::vector<uint8_t> y(6), uv(4);
+        k.yuy2_to_nv12(yuy2.data(), 4, y.data(), 2, uv.data(), 2, 2, 3);
+        t.expect("yuy2_to_nv12 luma", isa, expected_y, y);
+        t.expect("yuy2_to_nv12 chroma", isa, expected_uv, uv);
+        k.uyvy_to_nv12(uyvy.data(), 4, y.data(), 2, uv.data(), 2, 2, 3);
+        t.expect("uyvy_to_nv12 luma", isa, expected_y, y);
+        t.expect("uyvy_to_nv12 chroma", isa, expected_uv, uv);
+
+        // 4x2 image, a chroma row of two samples, U comes first in NV12
+        const std::vector<uint8_t> u = {1, 2}, v = {3, 4};
+        std::vector<uint8_t> nv12_uv(4), back_u(2), back_v(2);
+        k.i420_to_nv12(u.data(), 2, v.data(), 2, nv12_uv.data(), 4, 4, 2);
+        t.expect("i420_to_nv12", isa, {1, 3, 2, 4}, nv12_uv);
+        k.nv12_to_i420(nv12_uv.data(), 4, back_u.data(), 2, back_v.data(), 2, 4, 2);
+        t.expect("nv12_to_i420 u", isa, u, back_u);
+        t.expect("nv12_to_i420 v", isa, v, back_v);
+
+        // One pixel each, the source channels are numbered in memory order
+        auto swizzle = [&](const std::string& name, swizzle_fn fn, std::vector<uint8_t> src, std::vector<uint8_t> expected) {
+            std::vector<uint8_t> dst(expected.size());
+            fn(src.data(), static_cast<int32_t>(src.size()), dst.data(), static_cast<int32_t>(dst.size()), 1, 1);
+            t.expect(name, isa, expected, dst);
+        };
+        swizzle("rgba_to_bgra", k.rgba_to_bgra, {1, 2, 3, 4}, {3, 2, 1, 4});
+        swizzle("argb_to_bgra", k.argb_to_bgra, {1, 2, 3, 4}, {4, 3, 2, 1});
+        swizzle("rgb_to_bgra", k.rgb_to_bgra, {1, 2, 3}, {3, 2, 1, 255});
+        swizzle("rgb_to_rgba", k.rgb_to_rgba, {1, 2, 3}, {1, 2, 3, 255});
+        swizzle("bgra_to_rgb", k.bgra_to_rgb, {1, 2, 3, 4}, {3, 2, 1});
+    }
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+    // The seed may be passed to reproduce a failure
+    auto seed = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : std::random_device {}();
+    std::cout << "[INFO] Seed " << seed << std::endl;
+
+    test_runner t(seed);
+    auto supported = get_supported_instruction_set();
+    for (auto isa : {instruction_set::scalar, instruction_set::sse41, instruction_set::avx2}) {
+        if (static_cast<int>(isa) <= static_cast<int>(supported)) {
+            test_fixtures(t, isa);
+        }
+    }
+    for (auto isa : {instruction_set::sse41, instruction_set::avx2}) {
+        if (static_cast<int>(isa) > static_cast<int>(supported)) {
+            std::cout << "[INFO] " << to_string(isa) << " is not supported by the CPU, skipped" << std::endl;
+            continue;
+        }
+        for (int32_t i = 0; i < iterations; ++i) {
+            auto c = t.make_case(i);
+            test_packed_yuv_to_nv12(t, "yuy2_to_nv12", &kernels::yuy2_to_nv12, isa, c);
+            test_packed_yuv_to_nv12(t, "uyvy_to_nv12", &kernels::uyvy_to_nv12, isa, c);
+            test_i420_to_nv12(t, isa, c);
+            test_nv12_to_i420(t, isa, c);
+            test_swizzle(t, "rgba_to_bgra", &kernels::rgba_to_bgra, 4, 4, isa, c);
+            test_swizzle(t, "argb_to_bgra", &kernels::argb_to_bgra, 4, 4, isa, c);
+            test_swizzle(t, "rgb_to_bgra", &kernels::rgb_to_bgra, 3, 4, isa, c);
+            test_swizzle(t, "rgb_to_rgba", &kernels::rgb_to_rgba, 3, 4, isa, c);
+            test_swizzle(t, "bgra_to_rgb", &kernels::bgra_to_rgb, 4, 3, isa, c);
+        }
+    }
+
+    std::cout << "[INFO] " << t.get_checks() << " checks, " << t.get_failures() << " failed" << std::endl;
+    return t.get_failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#include "libraries/utils/resize_debouncer.hpp"
+#include "test_utils.hpp"
+
+// Checks which sizes resize_debouncer passes on and its applied and avoided counts, on a clock
+// driven by the test
+
+namespace
+{
+
+    using namespace std::chrono_literals;
+    using bnb::gl::resize_debouncer;
+
+    resize_debouncer::size make_size(int32_t width, int32_t height)
+    {
+        return {width, height, width * 2, height * 2};
+    }
+
+    void test_burst(bnb::test::checker& c)
+    {
+        resize_debouncer debouncer(100ms);
+        auto t0 = resize_debouncer::clock::time_point {} + 1h;
+
+        c.expect(!debouncer.poll(t0).has_value() && !debouncer.get_deadline().has_value(), "nothing pushed: nothing to apply");
+
+        // A dragged window edge
+        debouncer.push(make_size(640, 480), t0);
+        debouncer.push(make_size(650, 480), t0 + 10ms);
+        debouncer.push(make_size(660, 490), t0 + 20ms);
+        c.expect(debouncer.get_deadline() == t0 + 120ms, "the deadline follows the last resize");
+        c.expect(!debouncer.poll(t0 + 119ms).has_value(), "nothing is applied before the quiet interval");
+
+        auto settled = debouncer.poll(t0 + 120ms);
+        c.expect(settled.has_value() && *settled == make_size(660, 490), "the last size of a burst is applied");
+        c.expect(!debouncer.poll(t0 + 500ms).has_value() && !debouncer.get_deadline().has_value(), "a size is applied once");
+
+        auto s = debouncer.get_statistics();
+        c.expect(s.resizes == 3 && s.applied == 1 && s.avoided == 2, "burst: one applied, two avoided");
+    }
+
+    void test_same_size(bnb::test::checker& c)
+    {
+        resize_debouncer debouncer(100ms);
+        auto t0 = resize_debouncer::clock::time_point {} + 1h;
+
+        debouncer.push(make_size(640, 480), t0);
+        debouncer.poll(t0 + 100ms);
+
+        // Dragged away and back, the framebuffers already have this size
+        debouncer.push(make_size(700, 480), t0 + 200ms);
+        debouncer.push(make_size(640, 480), t0 + 210ms);
+        c.expect(!debouncer.poll(t0 + 310ms).has_value(), "a burst ending at the applied size is not applied");
+
+        auto s = debouncer.get_statistics();
+        c.expect(s.resizes == 3 && s.applied == 1 && s.avoided == 2, "same size: the whole burst is avoided");
+
+        // The buffer size alone changes when the window moves to a display with another scale
+        debouncer.push({640, 480, 640, 480}, t0 + 400ms);
+        auto moved = debouncer.poll(t0 + 500ms);
+        c.expect(moved.has_value() && moved->buffer_width == 640, "a change of the buffer size alone is applied");
+        s = debouncer.get_statistics();
+        c.expect(s.resizes == 4 && s.applied == 2 && s.avoided == 2, "same size: statistics after the buffer change");
+    }
+
+} /* namespace */
+
+int main()
+{
+    bnb::test::checker c;
+    test_burst(c);
+    test_same_size(c);
+    return c.report();
+}
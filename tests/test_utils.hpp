@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace bnb::test
+{
+
+    // Counts the checks of a test executable, a failed check is printed when it is made
+    class checker
+    {
+    public:
+        bool expect(bool condition, const std::string& what)
+        {
+            if (!condition) {
+                std::cout << "[ERROR] " << what << std::endl;
+                ++m_failures;
+            }
+            ++m_checks;
+            return condition;
+        }
+
+        // Prints the totals, returns the exit code of the test
+        int report() const
+        {
+            std::cout << "[INFO] " << m_checks << " checks, " << m_failures << " failed" << std::endl;
+            return m_failures == 0 ? 0 : 1;
+        }
+
+    private:
+        int32_t m_failures {0};
+        int32_t m_checks {0};
+    }; /* class checker */
+
+} /* namespace bnb::test */
@@ -0,0 +1,104 @@
+#include "libraries/renderer/texture_triple_buffer.hpp"
+#include "test_utils.hpp"
+
+#include <string>
+#include <thread>
+
+// Checks that texture_triple_buffer hands over the latest frame and counts the frames it drops
+// and repeats, alone and with a producer and a consumer on their own threads
+
+namespace
+{
+
+    using bnb::render::texture_frame;
+    using bnb::render::texture_triple_buffer;
+
+    constexpr uint64_t threaded_frames = 200000;
+
+    texture_frame make_frame(uint64_t sequence)
+    {
+        texture_frame frame;
+        frame.texture = static_cast<GLuint>(sequence);
+        frame.sequence = sequence;
+        return frame;
+    }
+
+    void test_latest_wins(bnb::test::checker& c)
+    {
+        texture_triple_buffer buffer;
+        bool is_new = true;
+
+        buffer.consume(is_new);
+        c.expect(!is_new && buffer.get_duplicated_frames_count() == 1, "nothing published: the frame is not new and counted as duplicated");
+
+        c.expect(!buffer.publish(make_frame(1)).has_value(), "the first frame replaces nothing");
+        c.expect(buffer.has_new_frame(), "a published frame is pending");
+        auto& first = buffer.consume(is_new);
+        c.expect(is_new && first.sequence == 1, "the published frame is consumed");
+        c.expect(!buffer.has_new_frame(), "nothing is pending after consume");
+
+        auto& again = buffer.consume(is_new);
+        c.expect(!is_new && again.sequence == 1, "the consumer keeps the previous frame");
+        c.expect(buffer.get_duplicated_frames_count() == 2, "a repeated frame is counted as duplicated");
+
+        buffer.publish(make_frame(2));
+        auto replaced = buffer.publish(make_frame(3));
+        c.expect(replaced.has_value() && replaced->sequence == 2, "the frame never consumed is returned to the producer");
+        c.expect(buffer.get_dropped_frames_count() == 1, "a replaced frame is counted as dropped");
+        auto& latest = buffer.consume(is_new);
+        c.expect(is_new && latest.sequence == 3, "the consumer gets the latest frame");
+
+        // The frame held by the consumer is not overwritten by the producer
+        buffer.publish(make_frame(4));
+        buffer.publish(make_frame(5));
+        c.expect(latest.sequence == 3, "the consumed frame stays valid until the next consume");
+        c.expect(buffer.consume(is_new).sequence == 5, "the consumer gets the latest of several frames");
+        c.expect(buffer.get_dropped_frames_count() == 2 && buffer.get_duplicated_frames_count() == 2, "counters after several frames");
+    }
+
+    void test_threads(bnb::test::checker& c)
+    {
+        texture_triple_buffer buffer;
+        uint64_t returned = 0;
+        std::thread producer([&buffer, &returned]() {
+            for (uint64_t sequence = 1; sequence <= threaded_frames; ++sequence) {
+                if (buffer.publish(make_frame(sequence)).has_value()) {
+                    ++returned;
+                }
+            }
+        });
+
+        uint64_t consumed = 0;
+        uint64_t last_sequence = 0;
+        bool in_order = true;
+        bool consistent = true;
+        bool is_new = false;
+        while (last_sequence < threaded_frames) {
+            auto& frame = buffer.consume(is_new);
+            if (!is_new) {
+                continue;
+            }
+            ++consumed;
+            in_order = in_order && frame.sequence > last_sequence;
+            consistent = consistent && frame.texture == static_cast<GLuint>(frame.sequence);
+            last_sequence = frame.sequence;
+        }
+        producer.join();
+
+        c.expect(in_order, "threads: consumed frames only move forward");
+        c.expect(consistent, "threads: a consumed frame is never torn");
+        c.expect(returned == buffer.get_dropped_frames_count(), "threads: every dropped frame is returned to the producer");
+        c.expect(consumed + buffer.get_dropped_frames_count() == threaded_frames,
+            "threads: every frame is consumed or dropped, " + std::to_string(consumed) + " consumed, "
+                + std::to_string(buffer.get_dropped_frames_count()) + " dropped");
+    }
+
+} /* namespace */
+
+int main()
+{
+    bnb::test::checker c;
+    test_latest_wins(c);
+    test_threads(c);
+    return c.report();
+}